@@ -0,0 +1,325 @@
+/* CSI Spectrogram
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "csi_kernels.h"
+#include "csi_spectrogram.h"
+
+#define NSC CSI_SPEC_SUBCARRIERS
+#define PCA_WARMUP_ITERATIONS 16
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+typedef struct {
+    float *history;                                 // nfft frames x NSC amplitudes, ring
+    float mean[NSC];                                // running mean per subcarrier
+    float cov[NSC * NSC];                           // running covariance, upper triangle
+    float basis[CSI_SPEC_MAX_COMPONENTS][NSC];      // principal directions
+    int pos;                                        // oldest frame in history
+    int filled;
+    int since_emit;
+} csi_spec_link_t;
+
+struct csi_spectrogram {
+    csi_spec_config_t cfg;
+    int n_links;
+    csi_spec_link_t *links;
+    float alpha;                                    // covariance forgetting factor once the window is full, 1 / nfft
+
+    // FFT plan shared by all links
+    uint16_t *bitrev;
+    float *cos_tab;
+    float *sin_tab;
+    float *window;
+    float power_scale;                              // 1 / sum(window^2)
+
+    // Scratch
+    float *series;                                  // components x nfft projections
+    float *re;
+    float *im;
+};
+
+//------------------------------------------------------FFT Plan------------------------------------------------------
+static int plan_init(csi_spectrogram_t *s)
+{
+    int n = s->cfg.nfft;
+    s->bitrev = malloc(n * sizeof(uint16_t));
+    s->cos_tab = malloc(n / 2 * sizeof(float));
+    s->sin_tab = malloc(n / 2 * sizeof(float));
+    s->window = malloc(n * sizeof(float));
+    if (!s->bitrev || !s->cos_tab || !s->sin_tab || !s->window) return -1;
+
+    int bits = 0;
+    while ((1 << bits) < n) bits++;
+    for (int i = 0; i < n; i++) {
+        int r = 0;
+        for (int b = 0; b < bits; b++) {
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        s->bitrev[i] = (uint16_t)r;
+    }
+    for (int k = 0; k < n / 2; k++) {
+        s->cos_tab[k] = (float)cos(2.0 * M_PI * k / n);
+        s->sin_tab[k] = (float)-sin(2.0 * M_PI * k / n);
+    }
+
+    // Periodic Hann window
+    double energy = 0.0;
+    for (int i = 0; i < n; i++) {
+        s->window[i] = (float)(0.5 - 0.5 * cos(2.0 * M_PI * i / n));
+        energy += (double)s->window[i] * s->window[i];
+    }
+    s->power_scale = (float)(1.0 / energy);
+    return 0;
+}
+
+// In-place iterative radix-2 FFT
+static void fft(const csi_spectrogram_t *s, float *re, float *im)
+{
+    int n = s->cfg.nfft;
+    for (int i = 0; i < n; i++) {
+        int j = s->bitrev[i];
+        if (j > i) {
+            float t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+    for (int len = 2; len <= n; len <<= 1) {
+        int half = len >> 1;
+        int step = n / len;
+        for (int start = 0; start < n; start += len) {
+            for (int k = 0; k < half; k++) {
+                float wr = s->cos_tab[k * step];
+                float wi = s->sin_tab[k * step];
+                int a = start + k, b = a + half;
+                float xr = re[b] * wr - im[b] * wi;
+                float xi = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - xr;
+                im[b] = im[a] - xi;
+                re[a] += xr;
+                im[a] += xi;
+            }
+        }
+    }
+}
+
+//------------------------------------------------------PCA------------------------------------------------------
+static void cov_update(csi_spec_link_t *l, const float *x, float alpha)
+{
+    float d[NSC];
+    for (int i = 0; i < NSC; i++) {
+        l->mean[i] += alpha * (x[i] - l->mean[i]);
+        d[i] = x[i] - l->mean[i];
+    }
+    float keep = 1.0f - alpha;
+    for (int i = 0; i < NSC; i++) {
+        float *row = &l->cov[i * NSC];
+        float ad = alpha * d[i];
+        for (int j = i; j < NSC; j++) {
+            row[j] = keep * row[j] + ad * d[j];
+        }
+    }
+}
+
+static void cov_multiply(const csi_spec_link_t *l, const float *x, float *y)
+{
+    memset(y, 0, NSC * sizeof(float));
+    for (int i = 0; i < NSC; i++) {
+        const float *row = &l->cov[i * NSC];
+        float acc = row[i] * x[i];
+        for (int j = i + 1; j < NSC; j++) {
+            acc += row[j] * x[j];
+            y[j] += row[j] * x[i];
+        }
+        y[i] += acc;
+    }
+}
+
+// One orthogonal iteration, warm-started from the current basis so components stay stable between hops
+static void basis_refresh(csi_spec_link_t *l, int components)
+{
+    float next[CSI_SPEC_MAX_COMPONENTS][NSC];
+    for (int k = 0; k < components; k++) {
+        cov_multiply(l, l->basis[k], next[k]);
+        for (int p = 0; p < k; p++) {
+            float dot = 0.0f;
+            for (int i = 0; i < NSC; i++) dot += next[k][i] * next[p][i];
+            for (int i = 0; i < NSC; i++) next[k][i] -= dot * next[p][i];
+        }
+        float norm = 0.0f, align = 0.0f;
+        for (int i = 0; i < NSC; i++) {
+            norm += next[k][i] * next[k][i];
+            align += next[k][i] * l->basis[k][i];
+        }
+        if (norm < 1e-20f) {
+            // Flat covariance (e.g. during warm-up), keep the previous direction
+            memcpy(next[k], l->basis[k], sizeof(next[k]));
+            continue;
+        }
+        float scale = (align < 0.0f ? -1.0f : 1.0f) / sqrtf(norm);
+        for (int i = 0; i < NSC; i++) next[k][i] *= scale;
+    }
+    memcpy(l->basis, next, components * sizeof(next[0]));
+}
+
+//------------------------------------------------------Feature Frames------------------------------------------------------
+static void emit(csi_spectrogram_t *s, csi_spec_link_t *l, float *features)
+{
+    int n = s->cfg.nfft;
+    int comps = s->cfg.components;
+    int bins = n / 2 + 1;
+
+    basis_refresh(l, comps);
+
+    // Project the window, oldest frame first, and remove each series' mean
+    for (int k = 0; k < comps; k++) {
+        float *series = &s->series[k * n];
+        const float *b = l->basis[k];
+        float sum = 0.0f;
+        for (int t = 0; t < n; t++) {
+            const float *x = &l->history[((l->pos + t) % n) * NSC];
+            float acc = 0.0f;
+            for (int i = 0; i < NSC; i++) acc += b[i] * x[i];
+            series[t] = acc;
+            sum += acc;
+        }
+        float mean = sum / n;
+        for (int t = 0; t < n; t++) series[t] = (series[t] - mean) * s->window[t];
+    }
+
+    // Two real series per complex FFT: z = a + i b
+    for (int k = 0; k < comps; k += 2) {
+        const float *a = &s->series[k * n];
+        int has_b = k + 1 < comps;
+        memcpy(s->re, a, n * sizeof(float));
+        if (has_b) {
+            memcpy(s->im, &s->series[(k + 1) * n], n * sizeof(float));
+        } else {
+            memset(s->im, 0, n * sizeof(float));
+        }
+        fft(s, s->re, s->im);
+
+        float *out_a = &features[k * bins];
+        float *out_b = has_b ? &features[(k + 1) * bins] : NULL;
+        for (int f = 0; f < bins; f++) {
+            int g = (n - f) % n;
+            float ar = 0.5f * (s->re[f] + s->re[g]);
+            float ai = 0.5f * (s->im[f] - s->im[g]);
+            out_a[f] = 10.0f * log10f((ar * ar + ai * ai) * s->power_scale + 1e-12f);
+            if (out_b) {
+                float br = 0.5f * (s->im[f] + s->im[g]);
+                float bi = 0.5f * (s->re[g] - s->re[f]);
+                out_b[f] = 10.0f * log10f((br * br + bi * bi) * s->power_scale + 1e-12f);
+            }
+        }
+    }
+}
+
+//------------------------------------------------------Public API------------------------------------------------------
+csi_spectrogram_t *csi_spectrogram_create(const csi_spec_config_t *cfg, int n_links)
+{
+    int n = cfg->nfft;
+    if (n < 4 || n > CSI_SPEC_MAX_NFFT || (n & (n - 1)) != 0) return NULL;
+    if (cfg->hop < 1 || cfg->hop > n) return NULL;
+    if (cfg->components < 1 || cfg->components > CSI_SPEC_MAX_COMPONENTS) return NULL;
+    if (n_links < 1) return NULL;
+
+    csi_spectrogram_t *s = calloc(1, sizeof(*s));
+    if (!s) return NULL;
+    s->cfg = *cfg;
+    s->n_links = n_links;
+    s->alpha = 1.0f / n;
+
+    s->links = calloc(n_links, sizeof(csi_spec_link_t));
+    s->series = malloc((size_t)cfg->components * n * sizeof(float));
+    s->re = malloc(n * sizeof(float));
+    s->im = malloc(n * sizeof(float));
+    if (!s->links || !s->series || !s->re || !s->im || plan_init(s) != 0) {
+        csi_spectrogram_destroy(s);
+        return NULL;
+    }
+
+    for (int l = 0; l < n_links; l++) {
+        csi_spec_link_t *link = &s->links[l];
+        link->history = calloc((size_t)n * NSC, sizeof(float));
+        if (!link->history) {
+            csi_spectrogram_destroy(s);
+            return NULL;
+        }
+        // Start from subcarriers spread over the band
+        for (int k = 0; k < cfg->components; k++) {
+            link->basis[k][(k * NSC) / CSI_SPEC_MAX_COMPONENTS] = 1.0f;
+        }
+    }
+    return s;
+}
+
+void csi_spectrogram_destroy(csi_spectrogram_t *s)
+{
+    if (!s) return;
+    if (s->links) {
+        for (int l = 0; l < s->n_links; l++) free(s->links[l].history);
+    }
+    free(s->links);
+    free(s->bitrev);
+    free(s->cos_tab);
+    free(s->sin_tab);
+    free(s->window);
+    free(s->series);
+    free(s->re);
+    free(s->im);
+    free(s);
+}
+
+int csi_spectrogram_feature_size(const csi_spectrogram_t *s)
+{
+    return s->cfg.components * (s->cfg.nfft / 2 + 1);
+}
+
+const float *csi_spectrogram_basis(const csi_spectrogram_t *s, int link, int k)
+{
+    if (link < 0 || link >= s->n_links || k < 0 || k >= s->cfg.components) return NULL;
+    return s->links[link].basis[k];
+}
+
+int csi_spectrogram_push(csi_spectrogram_t *s, int link, const int8_t *csi, int len, float *features)
+{
+    if (link < 0 || link >= s->n_links || len < 2 * NSC) return -1;
+    csi_spec_link_t *l = &s->links[link];
+    int n = s->cfg.nfft;
+
+    // Overwrite the oldest frame, which makes the next one the oldest
+    float *x = &l->history[l->pos * NSC];
+    csi_amplitude_f32(csi, x, NSC);
+    // Plain running average while filling: the first frame seeds the mean, so the static
+    // profile never enters the covariance as a mean * mean^T term
+    cov_update(l, x, l->filled < n ? 1.0f / (l->filled + 1) : s->alpha);
+    l->pos = (l->pos + 1) % n;
+
+    if (l->filled < n) {
+        l->filled++;
+        if (l->filled < n) return 0;
+        // First full window: converge the basis before the first frame, later hops only track it
+        for (int i = 0; i < PCA_WARMUP_ITERATIONS; i++) {
+            basis_refresh(l, s->cfg.components);
+        }
+        l->since_emit = s->cfg.hop;
+    } else {
+        l->since_emit++;
+    }
+    if (l->since_emit < s->cfg.hop) return 0;
+
+    l->since_emit = 0;
+    emit(s, l, features);
+    return 1;
+}
@@ -0,0 +1,79 @@
+/* CSI Spectrogram
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/**
+ * Streaming STFT (Doppler spectrogram) features from CSI amplitudes, for the host.
+ *
+ * Frames are decoded with the receiver's csi_amplitude_f32(). Per link, a
+ * running covariance of the 57 subcarriers is kept (a plain average over the
+ * first `nfft` frames, exponentially weighted after that) and, at every hop,
+ * its top `components` principal directions are refreshed with one
+ * warm-started orthogonal iteration. The last `nfft` frames are projected onto
+ * them, Hann windowed and transformed with a precomputed radix-2 FFT plan.
+ * Components are transformed two at a time as the real and imaginary parts of
+ * one complex FFT.
+ *
+ * Every `hop` frames a link emits one fixed-size feature frame:
+ * components x (nfft / 2 + 1) log-power bins (dB), component-major.
+ *
+ * The engine is single-threaded; use one engine per thread to spread links
+ * over cores.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CSI_SPEC_SUBCARRIERS    57
+#define CSI_SPEC_MAX_COMPONENTS 8
+#define CSI_SPEC_MAX_NFFT       1024
+
+typedef struct {
+    int nfft;        /**< STFT length in frames, power of two up to CSI_SPEC_MAX_NFFT */
+    int hop;         /**< frames between feature frames, 1..nfft */
+    int components;  /**< principal components kept, 1..CSI_SPEC_MAX_COMPONENTS */
+} csi_spec_config_t;
+
+typedef struct csi_spectrogram csi_spectrogram_t;
+
+/**
+ * @brief Create an engine for `n_links` links sharing one FFT plan and window
+ * @return NULL if the configuration is invalid or memory is exhausted
+ */
+csi_spectrogram_t *csi_spectrogram_create(const csi_spec_config_t *cfg, int n_links);
+
+void csi_spectrogram_destroy(csi_spectrogram_t *s);
+
+/**
+ * @brief Number of floats in one feature frame
+ */
+int csi_spectrogram_feature_size(const csi_spectrogram_t *s);
+
+/**
+ * @brief Push one raw CSI frame (interleaved int8 I/Q) for a link
+ * @param[in] csi raw CSI buffer, the first 57 I/Q pairs are used
+ * @param[in] len buffer length in bytes
+ * @param[out] features csi_spectrogram_feature_size() floats, written when a frame is emitted
+ * @return 1 if a feature frame was written, 0 if not, -1 on invalid arguments
+ */
+int csi_spectrogram_push(csi_spectrogram_t *s, int link, const int8_t *csi, int len, float *features);
+
+/**
+ * @brief Principal direction `k` of a link, as used for its last feature frame
+ * @return CSI_SPEC_SUBCARRIERS floats of unit norm, NULL on invalid arguments
+ */
+const float *csi_spectrogram_basis(const csi_spectrogram_t *s, int link, int k);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,302 @@
+/* CSI Flash Log Test
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/**
+ * Runs csi_recv/main/csi_flash_log.c against the file-backed flash in shim/.
+ *
+ * Each record carries a sequence number, so every check comes down to "the
+ * drained records are consecutive, start where expected and none are counted
+ * twice". Covers ordering, acks and resends, recovery after a reboot, wrap-
+ * around drops, power loss part way through a flush and a full staging ring.
+ * Exits non-zero if any check fails. See README.md for the build command.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "csi_flash_log.h"
+#include "esp_shim.h"
+
+#define SECTOR_SIZE 4096
+#define SECTOR_COUNT 8
+#define PAYLOAD_LEN 114                      // one 57-subcarrier CSI frame
+#define RECORD_LEN (8 + ((PAYLOAD_LEN + 3) & ~3))
+#define MAX_RECORDS 4096
+
+static const char *image_path = "flash_log_test.img";
+static int failures;
+
+static uint32_t received[MAX_RECORDS];       // sequence numbers seen by the sink, in order
+static int n_received;
+static int sink_fails;
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            failures++; \
+            fprintf(stderr, "FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        } \
+    } while (0)
+
+//------------------------------------------------------Helpers------------------------------------------------------
+static esp_err_t sink(const uint8_t *batch, size_t len, uint32_t records)
+{
+    if (sink_fails) return ESP_FAIL;
+    size_t off = 0;
+    uint32_t seen = 0;
+    while (off + sizeof(csi_log_record_hdr_t) <= len) {
+        csi_log_record_hdr_t hdr;
+        memcpy(&hdr, batch + off, sizeof(hdr));
+        if (hdr.type == CSI_LOG_TYPE_FRAME && hdr.len == PAYLOAD_LEN && n_received < MAX_RECORDS) {
+            memcpy(&received[n_received++], batch + off + sizeof(hdr), sizeof(uint32_t));
+        }
+        off += sizeof(hdr) + ((hdr.len + 3u) & ~3u);
+        seen++;
+    }
+    CHECK(off == len);
+    CHECK(seen == records);
+    return ESP_OK;
+}
+
+static void reset_received(void)
+{
+    n_received = 0;
+    sink_fails = 0;
+}
+
+// Stage records first..first+count-1, flushing often enough that the staging ring never fills
+static void append_range(uint32_t first, uint32_t count)
+{
+    uint8_t payload[PAYLOAD_LEN];
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t seq = first + i;
+        memset(payload, (int)(seq & 0xFF), sizeof(payload));
+        memcpy(payload, &seq, sizeof(seq));
+        CHECK(csi_flash_log_append(CSI_LOG_TYPE_FRAME, payload, PAYLOAD_LEN) == ESP_OK);
+        if (i % 32 == 31) CHECK(csi_flash_log_flush() == ESP_OK);
+    }
+    CHECK(csi_flash_log_flush() == ESP_OK);
+}
+
+static void drain_all(void)
+{
+    while (csi_flash_log_drain(sink, 8 * RECORD_LEN) > 0) {
+        csi_flash_log_drain_ack(true);
+    }
+}
+
+// The sink saw exactly first..first+count-1
+static int received_run(uint32_t first, int count)
+{
+    if (n_received != count) return 0;
+    for (int i = 0; i < count; i++) {
+        if (received[i] != first + (uint32_t)i) return 0;
+    }
+    return 1;
+}
+
+static void boot(int fresh)
+{
+    if (fresh) CHECK(esp_shim_flash_open(image_path, CSI_LOG_PARTITION_LABEL,
+                                         SECTOR_SIZE * SECTOR_COUNT, SECTOR_SIZE, 1) == 0);
+    CHECK(csi_flash_log_init() == ESP_OK);
+    reset_received();
+}
+
+//------------------------------------------------------Tests------------------------------------------------------
+static void test_order(void)
+{
+    boot(1);
+    append_range(0, 100);
+    CHECK(csi_flash_log_pending() == 100);
+    drain_all();
+    CHECK(received_run(0, 100));
+    CHECK(csi_flash_log_pending() == 0);
+
+    csi_flash_log_stats_t stats;
+    csi_flash_log_get_stats(&stats);
+    CHECK(stats.records_written == 100);
+    CHECK(stats.records_drained == 100);
+    CHECK(stats.records_dropped == 0);
+    CHECK(stats.stage_dropped == 0);
+    CHECK(esp_shim_flash_overwrites() == 0);
+}
+
+static void test_ack(void)
+{
+    boot(1);
+    append_range(0, 10);
+
+    // No ack yet: nothing is marked and a second drain waits for the first
+    CHECK(csi_flash_log_drain(sink, 8 * RECORD_LEN) == 8);
+    CHECK(csi_flash_log_pending() == 10);
+    CHECK(csi_flash_log_drain(sink, 8 * RECORD_LEN) == 0);
+
+    // Negative ack: the same records go out again
+    csi_flash_log_drain_ack(false);
+    CHECK(csi_flash_log_drain(sink, 8 * RECORD_LEN) == 8);
+    csi_flash_log_drain_ack(true);
+    CHECK(csi_flash_log_pending() == 2);
+    CHECK(n_received == 16 && received[0] == 0 && received[8] == 0 && received[15] == 7);
+
+    // Lost ack: resent after the timeout
+    reset_received();
+    CHECK(csi_flash_log_drain(sink, 8 * RECORD_LEN) == 2);
+    esp_shim_advance_time_us((int64_t)CSI_LOG_ACK_TIMEOUT_MS * 1000 - 1);
+    CHECK(csi_flash_log_drain(sink, 8 * RECORD_LEN) == 0);
+    esp_shim_advance_time_us(1);
+    CHECK(csi_flash_log_drain(sink, 8 * RECORD_LEN) == 2);
+    csi_flash_log_drain_ack(true);
+    CHECK(n_received == 4 && received[0] == 8 && received[2] == 8);
+    CHECK(csi_flash_log_pending() == 0);
+
+    // Sink failure: nothing in flight, nothing marked
+    append_range(10, 5);
+    reset_received();
+    sink_fails = 1;
+    CHECK(csi_flash_log_drain(sink, 8 * RECORD_LEN) == 0);
+    CHECK(csi_flash_log_pending() == 5);
+    sink_fails = 0;
+    drain_all();
+    CHECK(received_run(10, 5));
+
+    csi_flash_log_stats_t stats;
+    csi_flash_log_get_stats(&stats);
+    CHECK(stats.drain_timeouts == 1);
+    CHECK(stats.records_drained == 15);
+}
+
+static void test_reboot(void)
+{
+    boot(1);
+    append_range(0, 50);
+    CHECK(csi_flash_log_drain(sink, 20 * RECORD_LEN) == 20);
+    csi_flash_log_drain_ack(true);
+    CHECK(csi_flash_log_drain(sink, 10 * RECORD_LEN) == 10);  // in flight when power goes
+
+    boot(0);
+    CHECK(csi_flash_log_pending() == 30);
+    append_range(50, 10);
+    drain_all();
+    CHECK(received_run(20, 40));
+
+    // A drained log stays drained across reboots
+    boot(0);
+    CHECK(csi_flash_log_pending() == 0);
+    CHECK(esp_shim_flash_overwrites() == 0);
+}
+
+static void test_wrap(void)
+{
+    const uint32_t total = 1000;
+    boot(1);
+    append_range(0, total);
+
+    csi_flash_log_stats_t stats;
+    csi_flash_log_get_stats(&stats);
+    CHECK(stats.records_dropped > 0);
+    CHECK(stats.pending + stats.records_dropped == total);
+
+    // Recovery opens a fresh sector, which costs the oldest one when the ring is full
+    boot(0);
+    uint32_t pending = csi_flash_log_pending();
+    CHECK(pending <= stats.pending && pending + SECTOR_SIZE / RECORD_LEN >= stats.pending);
+    drain_all();
+    CHECK(received_run(total - pending, (int)pending));
+
+    // Sequential rotation keeps erases within one cycle of each other
+    uint32_t lo = esp_shim_flash_erase_count(0), hi = lo;
+    for (uint32_t s = 1; s < SECTOR_COUNT; s++) {
+        uint32_t e = esp_shim_flash_erase_count(s);
+        if (e < lo) lo = e;
+        if (e > hi) hi = e;
+    }
+    CHECK(hi - lo <= 1);
+    CHECK(esp_shim_flash_overwrites() == 0);
+}
+
+static void test_torn_write(void)
+{
+    // Cut the power at every point of a multi-batch flush, headers and commit bytes included
+    int before = failures;
+    for (long tear = 0; tear <= 3 * 1024; tear += 37) {
+        boot(1);
+        append_range(0, 40);
+        uint8_t payload[PAYLOAD_LEN] = { 0 };
+        for (uint32_t seq = 40; seq < 60; seq++) {
+            memcpy(payload, &seq, sizeof(seq));
+            CHECK(csi_flash_log_append(CSI_LOG_TYPE_FRAME, payload, PAYLOAD_LEN) == ESP_OK);
+        }
+        esp_shim_flash_tear_after(tear);
+        csi_flash_log_flush();
+        esp_shim_power_cycle();
+
+        boot(0);
+        uint32_t pending = csi_flash_log_pending();
+        CHECK(pending >= 40 && pending <= 60);
+        append_range(pending, 5);
+        drain_all();
+        CHECK(received_run(0, (int)pending + 5));
+        CHECK(esp_shim_flash_overwrites() == 0);
+        if (failures != before) {
+            fprintf(stderr, "  (tear after %ld bytes)\n", tear);
+            return;
+        }
+    }
+}
+
+static void test_stage_full(void)
+{
+    boot(1);
+    uint8_t payload[PAYLOAD_LEN] = { 0 };
+    uint32_t accepted = 0, rejected = 0;
+    for (uint32_t seq = 0; seq < 100; seq++) {
+        memcpy(payload, &seq, sizeof(seq));
+        if (csi_flash_log_append(CSI_LOG_TYPE_FRAME, payload, PAYLOAD_LEN) == ESP_OK) {
+            CHECK(rejected == 0);   // drops only ever hit the newest records
+            accepted++;
+        } else {
+            rejected++;
+        }
+    }
+    CHECK(rejected > 0);
+    CHECK(csi_flash_log_flush() == ESP_OK);
+    drain_all();
+    CHECK(received_run(0, (int)accepted));
+
+    csi_flash_log_stats_t stats;
+    csi_flash_log_get_stats(&stats);
+    CHECK(stats.stage_dropped == rejected);
+    CHECK(stats.records_written == accepted);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1) image_path = argv[1];
+
+    struct {
+        const char *name;
+        void (*run)(void);
+    } tests[] = {
+        { "order", test_order },
+        { "ack", test_ack },
+        { "reboot", test_reboot },
+        { "wrap", test_wrap },
+        { "torn_write", test_torn_write },
+        { "stage_full", test_stage_full },
+    };
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        int before = failures;
+        tests[i].run();
+        printf("%-12s %s\n", tests[i].name, failures == before ? "ok" : "FAILED");
+    }
+    esp_shim_flash_close();
+    remove(image_path);
+
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,299 @@
+/* CSI Hampel Filter Benchmark
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/**
+ * Benchmarks csi_recv/main/csi_hampel.c against a sort-per-window reference
+ * of the same causal estimator and checks that both give identical output.
+ * Its scale is the median of past residuals, so it is also compared with a
+ * true Hampel filter (median and MAD of the current window) to show how far
+ * that approximation moves the replacements.
+ *
+ * Without arguments the input is synthetic amplitudes with injected spikes,
+ * and spike recall / false replacements are reported. With a capture file
+ * (CSV with one "[i,q,...]" CSI array per line, as recorded by the receiver)
+ * the first 57 I/Q pairs of every frame are replayed and the motion std_mean
+ * is compared with and without the filter. See README.md for build commands.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "csi_kernels.h"
+#include "csi_hampel.h"
+
+#define FRAME_LEN 57
+#define WINDOW_SIZE 100
+#define STRIDE 50
+#define MAX_FRAMES 200000
+#define SYNTH_FRAMES 20000
+
+#define HAMPEL_WINDOW 9
+#define HAMPEL_SIGMAS 3.0f
+#define HAMPEL_MIN_DEV 2.0f
+
+static float *frames;          // input, FRAME_LEN per frame
+static float *out_fast;        // csi_hampel output
+static float *out_ref;         // reference output
+static float *out_true;        // true Hampel output
+static unsigned char *spikes;  // injected spike mask (synthetic input only)
+static int n_frames;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+//------------------------------------------------------Sort-per-window Reference------------------------------------------------------
+static int cmp_float(const void *a, const void *b)
+{
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+static float sorted_median(const float *ring, int n)
+{
+    float tmp[CSI_HAMPEL_MAX_WINDOW];
+    memcpy(tmp, ring, n * sizeof(float));
+    qsort(tmp, n, sizeof(float), cmp_float);
+    return (n & 1) ? tmp[n / 2] : 0.5f * (tmp[n / 2 - 1] + tmp[n / 2]);
+}
+
+static void reference_filter(float *data, int n_frames, int window)
+{
+    static float val[FRAME_LEN][CSI_HAMPEL_MAX_WINDOW];
+    static float res[FRAME_LEN][CSI_HAMPEL_MAX_WINDOW];
+    for (int t = 0; t < n_frames; t++) {
+        int slot = t % window;
+        int count = t + 1 < window ? t + 1 : window;
+        for (int i = 0; i < FRAME_LEN; i++) {
+            float x = data[t * FRAME_LEN + i];
+            val[i][slot] = x;
+            float med = sorted_median(val[i], count);
+            float resid = fabsf(x - med);
+            if (t >= window) {
+                float limit = HAMPEL_SIGMAS * 1.4826f * sorted_median(res[i], window);
+                if (limit < HAMPEL_MIN_DEV) limit = HAMPEL_MIN_DEV;
+                if (resid > limit) data[t * FRAME_LEN + i] = med;
+            }
+            res[i][slot] = resid;
+        }
+    }
+}
+
+//------------------------------------------------------True Hampel Reference------------------------------------------------------
+// Same causal window and threshold, but the scale is the MAD of the current window
+static void true_hampel_filter(float *data, int n_frames, int window, float min_dev)
+{
+    static float val[FRAME_LEN][CSI_HAMPEL_MAX_WINDOW];
+    float dev[CSI_HAMPEL_MAX_WINDOW];
+    for (int t = 0; t < n_frames; t++) {
+        int slot = t % window;
+        int count = t + 1 < window ? t + 1 : window;
+        for (int i = 0; i < FRAME_LEN; i++) {
+            float x = data[t * FRAME_LEN + i];
+            val[i][slot] = x;
+            float med = sorted_median(val[i], count);
+            if (t < window) continue;  // csi_hampel waits for a full residual window too
+            for (int j = 0; j < window; j++) dev[j] = fabsf(val[i][j] - med);
+            float limit = HAMPEL_SIGMAS * 1.4826f * sorted_median(dev, window);
+            if (limit < min_dev) limit = min_dev;
+            if (fabsf(x - med) > limit) data[t * FRAME_LEN + i] = med;
+        }
+    }
+}
+
+//------------------------------------------------------Inputs------------------------------------------------------
+static void make_synthetic(void)
+{
+    srand(7310);
+    n_frames = SYNTH_FRAMES;
+    for (int t = 0; t < n_frames; t++) {
+        for (int i = 0; i < FRAME_LEN; i++) {
+            float base = 20.0f + 5.0f * sinf(0.02f * t + 0.1f * i);
+            float noise = ((rand() % 1000) / 1000.0f - 0.5f) * 2.0f;
+            float x = base + noise;
+            if (rand() % 200 == 0) {
+                x += 30.0f + rand() % 30;
+                spikes[t * FRAME_LEN + i] = 1;
+            }
+            frames[t * FRAME_LEN + i] = x;
+        }
+    }
+}
+
+static int load_capture(const char *path)
+{
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        perror(path);
+        return -1;
+    }
+
+    static char line[1 << 16];
+    int8_t iq[512];
+    n_frames = 0;
+    while (n_frames < MAX_FRAMES && fgets(line, sizeof(line), fp)) {
+        char *p = strchr(line, '[');
+        if (!p) continue;
+        int n = 0;
+        while (*p && *p != ']' && n < (int)sizeof(iq)) {
+            p++;
+            iq[n++] = (int8_t)strtol(p, &p, 10);
+        }
+        // Like the firmware, keep the first 57 I/Q pairs of each frame
+        if (n < 2 * FRAME_LEN || *p != ']') continue;
+        csi_amplitude_f32(iq, &frames[n_frames * FRAME_LEN], FRAME_LEN);
+        n_frames++;
+    }
+    fclose(fp);
+    return 0;
+}
+
+//------------------------------------------------------Reports------------------------------------------------------
+static int count_replaced(const float *out)
+{
+    int n = 0;
+    for (int k = 0; k < n_frames * FRAME_LEN; k++) n += out[k] != frames[k];
+    return n;
+}
+
+static void spike_report(const char *label, const float *out)
+{
+    int injected = 0, caught = 0, false_hits = 0;
+    for (int k = HAMPEL_WINDOW * FRAME_LEN; k < n_frames * FRAME_LEN; k++) {
+        int hit = out[k] != frames[k];
+        injected += spikes[k];
+        caught += spikes[k] && hit;
+        false_hits += !spikes[k] && hit;
+    }
+    printf("%-14s spike recall %.2f%% (%d/%d), false replacements %d\n",
+           label, 100.0 * caught / injected, caught, injected, false_hits);
+}
+
+static void motion_std(const float *data, float *std_min, float *std_max, float *std_avg)
+{
+    int n = 0;
+    *std_min = INFINITY;
+    *std_max = 0.0f;
+    *std_avg = 0.0f;
+    for (int end = WINDOW_SIZE; end <= n_frames; end += STRIDE) {
+        float sum[FRAME_LEN] = {0}, sum_sq[FRAME_LEN] = {0};
+        for (int w = end - WINDOW_SIZE; w < end; w++) {
+            csi_window_accumulate_f32(&data[w * FRAME_LEN], sum, sum_sq, FRAME_LEN);
+        }
+        float std_sum = 0.0f;
+        for (int i = 0; i < FRAME_LEN; i++) {
+            float mean = sum[i] / WINDOW_SIZE;
+            std_sum += sqrtf(fmaxf(sum_sq[i] / WINDOW_SIZE - mean * mean, 0.0f));
+        }
+        float std_mean = std_sum / FRAME_LEN;
+        if (std_mean < *std_min) *std_min = std_mean;
+        if (std_mean > *std_max) *std_max = std_mean;
+        *std_avg += std_mean;
+        n++;
+    }
+    if (n) *std_avg /= n;
+}
+
+// Run csi_hampel (into out_ref) and the true Hampel filter on the input and report where they disagree
+static void compare_true_hampel(float min_dev, int synthetic)
+{
+    static csi_hampel_t filter;
+    size_t bytes = (size_t)n_frames * FRAME_LEN * sizeof(float);
+    memcpy(out_ref, frames, bytes);
+    memcpy(out_true, frames, bytes);
+    csi_hampel_init(&filter, HAMPEL_WINDOW, HAMPEL_SIGMAS, min_dev);
+    for (int t = 0; t < n_frames; t++) {
+        csi_hampel_process_frame(&filter, &out_ref[t * FRAME_LEN], FRAME_LEN);
+    }
+    true_hampel_filter(out_true, n_frames, HAMPEL_WINDOW, min_dev);
+
+    int only_fast = 0, only_true = 0;
+    for (int k = 0; k < n_frames * FRAME_LEN; k++) {
+        int hit_fast = out_ref[k] != frames[k];
+        int hit_true = out_true[k] != frames[k];
+        only_fast += hit_fast && !hit_true;
+        only_true += hit_true && !hit_fast;
+    }
+    printf("min_dev %.1f: csi_hampel replaced %d, true Hampel (window MAD) replaced %d; "
+           "csi_hampel only %d, true Hampel only %d\n",
+           min_dev, count_replaced(out_ref), count_replaced(out_true), only_fast, only_true);
+    if (synthetic) {
+        spike_report("  csi_hampel", out_ref);
+        spike_report("  true Hampel", out_true);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    frames = calloc((size_t)MAX_FRAMES * FRAME_LEN, sizeof(float));
+    out_fast = calloc((size_t)MAX_FRAMES * FRAME_LEN, sizeof(float));
+    out_ref = calloc((size_t)MAX_FRAMES * FRAME_LEN, sizeof(float));
+    out_true = calloc((size_t)MAX_FRAMES * FRAME_LEN, sizeof(float));
+    spikes = calloc((size_t)MAX_FRAMES * FRAME_LEN, 1);
+    if (!frames || !out_fast || !out_ref || !out_true || !spikes) return 1;
+
+    if (argc > 1) {
+        if (load_capture(argv[1]) != 0) return 1;
+        printf("capture: %s, %d frames\n", argv[1], n_frames);
+    } else {
+        make_synthetic();
+        printf("synthetic: %d frames\n", n_frames);
+    }
+    if (n_frames == 0) return 1;
+
+    size_t bytes = (size_t)n_frames * FRAME_LEN * sizeof(float);
+    memcpy(out_fast, frames, bytes);
+    memcpy(out_ref, frames, bytes);
+
+    static csi_hampel_t filter;
+    csi_hampel_init(&filter, HAMPEL_WINDOW, HAMPEL_SIGMAS, HAMPEL_MIN_DEV);
+    double t0 = now_s();
+    for (int t = 0; t < n_frames; t++) {
+        csi_hampel_process_frame(&filter, &out_fast[t * FRAME_LEN], FRAME_LEN);
+    }
+    double t_fast = now_s() - t0;
+
+    t0 = now_s();
+    reference_filter(out_ref, n_frames, HAMPEL_WINDOW);
+    double t_ref = now_s() - t0;
+
+    int mismatches = 0;
+    for (int k = 0; k < n_frames * FRAME_LEN; k++) {
+        if (out_fast[k] != out_ref[k]) mismatches++;
+    }
+
+    printf("window %d, memory %zu bytes for %d subcarriers\n",
+           HAMPEL_WINDOW, sizeof(filter), CSI_HAMPEL_MAX_CHANNELS);
+    printf("heaps: %8.1f ns/frame   sort: %8.1f ns/frame   speedup %.2fx   mismatches %d\n",
+           t_fast / n_frames * 1e9, t_ref / n_frames * 1e9, t_ref / t_fast, mismatches);
+    printf("replaced %u of %u samples (%.3f%%)\n",
+           filter.replaced, filter.samples, 100.0 * filter.replaced / filter.samples);
+
+    // With min_dev = 0 the threshold is set by the scale alone, which is where the two estimators differ
+    compare_true_hampel(HAMPEL_MIN_DEV, argc <= 1);
+    compare_true_hampel(0.0f, argc <= 1);
+
+    float raw_min, raw_max, raw_avg, filt_min, filt_max, filt_avg;
+    motion_std(frames, &raw_min, &raw_max, &raw_avg);
+    motion_std(out_fast, &filt_min, &filt_max, &filt_avg);
+    printf("std_mean raw:      min %.3f  avg %.3f  max %.3f\n", raw_min, raw_avg, raw_max);
+    printf("std_mean filtered: min %.3f  avg %.3f  max %.3f\n", filt_min, filt_avg, filt_max);
+
+    free(frames);
+    free(out_fast);
+    free(out_ref);
+    free(out_true);
+    free(spikes);
+    return mismatches != 0;
+}
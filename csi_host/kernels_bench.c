@@ -0,0 +1,135 @@
+/* CSI Kernels Microbenchmark
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/**
+ * Times each kernel in csi_recv/main/csi_kernels.c against its scalar
+ * reference and reports the largest difference between the two. Exits
+ * non-zero if the amplitude kernel is not bit-exact or the accumulate
+ * kernel differs by more than ACCUMULATE_REL_TOL.
+ * See README.md for build commands.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "csi_kernels.h"
+
+#define FRAME_LEN 57
+#define WINDOW_SIZE 100
+#define ITERATIONS 20000
+#define ACCUMULATE_REL_TOL 1e-5f // relative to the reference sum
+
+static int8_t iq[2 * FRAME_LEN * WINDOW_SIZE];
+static float amp_ref[FRAME_LEN * WINDOW_SIZE];
+static float amp_vec[FRAME_LEN * WINDOW_SIZE];
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static float max_abs_diff(const float *a, const float *b, int n)
+{
+    float d = 0.0f;
+    for (int i = 0; i < n; i++) {
+        float e = fabsf(a[i] - b[i]);
+        if (e > d) d = e;
+    }
+    return d;
+}
+
+static float max_rel_diff(const float *ref, const float *b, int n)
+{
+    float d = 0.0f;
+    for (int i = 0; i < n; i++) {
+        float e = fabsf(ref[i] - b[i]) / fmaxf(fabsf(ref[i]), 1.0f);
+        if (e > d) d = e;
+    }
+    return d;
+}
+
+static int bench_amplitude(void)
+{
+    const int n = FRAME_LEN * WINDOW_SIZE;
+    double t0 = now_s();
+    for (int it = 0; it < ITERATIONS / 10; it++) {
+        csi_amplitude_f32_ref(iq, amp_ref, n);
+    }
+    double t_ref = now_s() - t0;
+
+    t0 = now_s();
+    for (int it = 0; it < ITERATIONS / 10; it++) {
+        csi_amplitude_f32(iq, amp_vec, n);
+    }
+    double t_vec = now_s() - t0;
+
+    double frames = (double)(ITERATIONS / 10) * WINDOW_SIZE;
+    float diff = max_abs_diff(amp_ref, amp_vec, n);
+    printf("amplitude:  ref %8.1f ns/frame  %s %8.1f ns/frame  speedup %.2fx  max_diff %g\n",
+           t_ref / frames * 1e9, csi_kernels_backend(), t_vec / frames * 1e9,
+           t_ref / t_vec, diff);
+    if (diff != 0.0f) {
+        printf("FAIL: amplitude kernel is not bit-exact\n");
+        return 1;
+    }
+    return 0;
+}
+
+static int bench_accumulate(void)
+{
+    float sum_ref[FRAME_LEN], sum_sq_ref[FRAME_LEN];
+    float sum_vec[FRAME_LEN], sum_sq_vec[FRAME_LEN];
+    double t_ref = 0.0, t_vec = 0.0;
+
+    for (int it = 0; it < ITERATIONS; it++) {
+        memset(sum_ref, 0, sizeof(sum_ref));
+        memset(sum_sq_ref, 0, sizeof(sum_sq_ref));
+        double t0 = now_s();
+        for (int w = 0; w < WINDOW_SIZE; w++) {
+            csi_window_accumulate_f32_ref(amp_ref + w * FRAME_LEN, sum_ref, sum_sq_ref, FRAME_LEN);
+        }
+        t_ref += now_s() - t0;
+
+        memset(sum_vec, 0, sizeof(sum_vec));
+        memset(sum_sq_vec, 0, sizeof(sum_sq_vec));
+        t0 = now_s();
+        for (int w = 0; w < WINDOW_SIZE; w++) {
+            csi_window_accumulate_f32(amp_ref + w * FRAME_LEN, sum_vec, sum_sq_vec, FRAME_LEN);
+        }
+        t_vec += now_s() - t0;
+    }
+
+    float diff = max_rel_diff(sum_ref, sum_vec, FRAME_LEN);
+    float diff_sq = max_rel_diff(sum_sq_ref, sum_sq_vec, FRAME_LEN);
+    printf("accumulate: ref %8.1f ns/window %s %8.1f ns/window speedup %.2fx  max_rel_diff %g / %g\n",
+           t_ref / ITERATIONS * 1e9, csi_kernels_backend(), t_vec / ITERATIONS * 1e9,
+           t_ref / t_vec, diff, diff_sq);
+    if (diff > ACCUMULATE_REL_TOL || diff_sq > ACCUMULATE_REL_TOL) {
+        printf("FAIL: accumulate kernel exceeds relative tolerance %g\n", ACCUMULATE_REL_TOL);
+        return 1;
+    }
+    return 0;
+}
+
+int main(void)
+{
+    srand(7310);
+    for (size_t i = 0; i < sizeof(iq); i++) {
+        iq[i] = (int8_t)(rand() % 256 - 128);
+    }
+
+    printf("backend: %s\n", csi_kernels_backend());
+    int failed = bench_amplitude();
+    failed |= bench_accumulate();
+    return failed;
+}
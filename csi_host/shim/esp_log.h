@@ -0,0 +1,16 @@
+/* Host shim of esp_log.h: silent unless built with -DESP_SHIM_LOG */
+
+#pragma once
+
+#include <stdio.h>
+
+#ifdef ESP_SHIM_LOG
+#define ESP_SHIM_PRINT(level, tag, fmt, ...) fprintf(stderr, level " (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#else
+#define ESP_SHIM_PRINT(level, tag, fmt, ...) do { (void)(tag); } while (0)
+#endif
+
+#define ESP_LOGE(tag, fmt, ...) ESP_SHIM_PRINT("E", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) ESP_SHIM_PRINT("W", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) ESP_SHIM_PRINT("I", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) do { (void)(tag); } while (0)
@@ -0,0 +1,175 @@
+/* Host shim of the ESP-IDF APIs used by csi_recv/main
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_err.h"
+#include "esp_partition.h"
+#include "esp_timer.h"
+#include "esp_shim.h"
+
+static esp_partition_t flash_part;
+static FILE *flash_file = NULL;
+static uint32_t *erase_counts = NULL;
+static uint32_t overwrites;
+static long tear_budget = -1;   // bytes left before power is lost, -1 if never
+static int powered = 1;
+static int64_t now_us;
+
+//------------------------------------------------------Controls------------------------------------------------------
+int esp_shim_flash_open(const char *path, const char *label, uint32_t size, uint32_t erase_size, int fresh)
+{
+    esp_shim_flash_close();
+    flash_file = fopen(path, fresh ? "w+b" : "r+b");
+    if (!flash_file) return -1;
+    memset(&flash_part, 0, sizeof(flash_part));
+    flash_part.type = ESP_PARTITION_TYPE_DATA;
+    flash_part.size = size;
+    flash_part.erase_size = erase_size;
+    snprintf(flash_part.label, sizeof(flash_part.label), "%s", label);
+    erase_counts = calloc(size / erase_size, sizeof(uint32_t));
+    overwrites = 0;
+    tear_budget = -1;
+    powered = 1;
+    if (fresh) {
+        unsigned char blank[256];
+        memset(blank, 0xFF, sizeof(blank));
+        for (uint32_t off = 0; off < size; off += sizeof(blank)) {
+            fwrite(blank, 1, sizeof(blank), flash_file);
+        }
+        fflush(flash_file);
+    }
+    return 0;
+}
+
+void esp_shim_flash_close(void)
+{
+    if (flash_file) fclose(flash_file);
+    flash_file = NULL;
+    free(erase_counts);
+    erase_counts = NULL;
+}
+
+void esp_shim_flash_tear_after(long bytes)
+{
+    tear_budget = bytes;
+}
+
+void esp_shim_power_cycle(void)
+{
+    tear_budget = -1;
+    powered = 1;
+}
+
+uint32_t esp_shim_flash_erase_count(uint32_t sector)
+{
+    return erase_counts ? erase_counts[sector] : 0;
+}
+
+uint32_t esp_shim_flash_overwrites(void)
+{
+    return overwrites;
+}
+
+void esp_shim_advance_time_us(int64_t us)
+{
+    now_us += us;
+}
+
+//------------------------------------------------------ESP-IDF API------------------------------------------------------
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK: return "ESP_OK";
+    case ESP_FAIL: return "ESP_FAIL";
+    case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+    default: return "UNKNOWN ERROR";
+    }
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return now_us;
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label)
+{
+    if (!flash_file || type != flash_part.type) return NULL;
+    if (subtype != ESP_PARTITION_SUBTYPE_ANY) return NULL;
+    if (label && strcmp(label, flash_part.label) != 0) return NULL;
+    return &flash_part;
+}
+
+static int in_range(const esp_partition_t *partition, size_t offset, size_t size)
+{
+    return partition == &flash_part && flash_file && offset + size <= flash_part.size && offset + size >= offset;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size)
+{
+    if (!in_range(partition, src_offset, size)) return ESP_ERR_INVALID_ARG;
+    if (fseek(flash_file, (long)src_offset, SEEK_SET) != 0) return ESP_FAIL;
+    return fread(dst, 1, size, flash_file) == size ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size)
+{
+    if (!in_range(partition, dst_offset, size)) return ESP_ERR_INVALID_ARG;
+    if (!powered) return ESP_FAIL;
+
+    size_t n = size;
+    if (tear_budget >= 0 && (long)size > tear_budget) {
+        n = (size_t)tear_budget;
+        powered = 0;
+    }
+    if (tear_budget >= 0) tear_budget -= (long)n;
+
+    unsigned char *cell = malloc(n ? n : 1);
+    if (!cell) return ESP_ERR_NO_MEM;
+    esp_err_t err = esp_partition_read(partition, dst_offset, cell, n);
+    if (err == ESP_OK) {
+        const unsigned char *in = src;
+        for (size_t i = 0; i < n; i++) {
+            if (in[i] & ~cell[i]) overwrites++;
+            cell[i] &= in[i];
+        }
+        if (fseek(flash_file, (long)dst_offset, SEEK_SET) != 0 || fwrite(cell, 1, n, flash_file) != n) {
+            err = ESP_FAIL;
+        }
+        fflush(flash_file);
+    }
+    free(cell);
+    if (err != ESP_OK) return err;
+    return powered ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size)
+{
+    if (!in_range(partition, offset, size)) return ESP_ERR_INVALID_ARG;
+    if (offset % flash_part.erase_size != 0 || size % flash_part.erase_size != 0) return ESP_ERR_INVALID_ARG;
+    if (!powered) return ESP_FAIL;
+
+    unsigned char *blank = malloc(flash_part.erase_size);
+    if (!blank) return ESP_ERR_NO_MEM;
+    memset(blank, 0xFF, flash_part.erase_size);
+    esp_err_t err = fseek(flash_file, (long)offset, SEEK_SET) == 0 ? ESP_OK : ESP_FAIL;
+    for (size_t off = 0; err == ESP_OK && off < size; off += flash_part.erase_size) {
+        if (fwrite(blank, 1, flash_part.erase_size, flash_file) != flash_part.erase_size) err = ESP_FAIL;
+        erase_counts[(offset + off) / flash_part.erase_size]++;
+    }
+    fflush(flash_file);
+    free(blank);
+    return err;
+}
@@ -0,0 +1,56 @@
+/* Host shim controls
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/**
+ * Test-side controls for the host ESP-IDF shim in this directory.
+ *
+ * The flash is one data partition kept in an image file. Writes behave like
+ * NOR flash: they can only clear bits, so the stored byte becomes old & new.
+ * A power loss can be injected part way through a write.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Open `path` as the partition `label`, erased first if `fresh`
+ * @return 0 on success, -1 if the image cannot be opened
+ */
+int esp_shim_flash_open(const char *path, const char *label, uint32_t size, uint32_t erase_size, int fresh);
+
+void esp_shim_flash_close(void);
+
+/**
+ * @brief Lose power after `bytes` more bytes are written; -1 disables
+ *
+ * The write that crosses the limit is cut short, and it and every later write
+ * or erase fail until esp_shim_power_cycle().
+ */
+void esp_shim_flash_tear_after(long bytes);
+
+/**
+ * @brief Restore power after a tear
+ */
+void esp_shim_power_cycle(void);
+
+/**
+ * @brief Erases seen by one sector since the image was opened
+ */
+uint32_t esp_shim_flash_erase_count(uint32_t sector);
+
+/**
+ * @brief Writes that tried to set a cleared bit, which NOR flash cannot do
+ */
+uint32_t esp_shim_flash_overwrites(void);
+
+/**
+ * @brief Move the esp_timer_get_time() clock forward
+ */
+void esp_shim_advance_time_us(int64_t us);
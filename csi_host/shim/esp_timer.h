@@ -0,0 +1,7 @@
+/* Host shim of esp_timer.h: a manual clock, see esp_shim.c */
+
+#pragma once
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time(void);
@@ -0,0 +1,13 @@
+/* Host shim of FreeRTOS.h for single-threaded tests: locks and critical sections are no-ops */
+
+#pragma once
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int portMUX_TYPE;
+
+#define portMAX_DELAY                 ((TickType_t)0xffffffffUL)
+#define portMUX_INITIALIZER_UNLOCKED  0
+#define portENTER_CRITICAL(mux)       ((void)(mux))
+#define portEXIT_CRITICAL(mux)        ((void)(mux))
@@ -0,0 +1,164 @@
+/* CSI Spectrogram Benchmark
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/**
+ * Feeds synthetic CSI for many links through csi_spectrogram.c on one core
+ * and reports throughput and how many links it could keep up with in real
+ * time. Each link sees a strong static subcarrier profile plus a motion tone,
+ * at its own frequency, along a fixed direction orthogonal to that profile.
+ * The first principal component must line up with the motion direction in
+ * every feature frame, from the first one on, or the bench exits non-zero.
+ * The strongest bin of the first component is also checked against the tone.
+ *
+ * Usage: spectrogram_bench [links] [nfft] [hop] [components] [seconds]
+ * See README.md for build commands.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "csi_spectrogram.h"
+
+#define FRAME_RATE_HZ 100.0f  // CONFIG_SEND_FREQUENCY in csi_send
+#define FRAME_BYTES   128     // 64 I/Q pairs, of which the first 57 are used
+#define NSC           CSI_SPEC_SUBCARRIERS
+#define MOTION_AMPLITUDE 40.0f  // peak amplitude change along the motion direction (vector norm)
+#define MIN_ALIGNMENT 0.95f     // |<PC1, motion direction>| required in every feature frame
+
+static float static_profile[FRAME_BYTES / 2];  // amplitude per subcarrier without motion
+static float motion_dir[NSC];                  // unit norm, orthogonal to static_profile
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static float link_tone_hz(int link)
+{
+    return 1.0f + (link % 8) * 2.5f;
+}
+
+// A frequency-selective static profile, and a motion direction on a band of subcarriers with the
+// profile projected out, so a PCA that tracks the static profile instead of the motion fails
+static void make_directions(void)
+{
+    for (int i = 0; i < FRAME_BYTES / 2; i++) {
+        static_profile[i] = 30.0f + 10.0f * cosf(0.11f * i);
+    }
+    float dot = 0.0f, energy = 0.0f;
+    for (int i = 0; i < NSC; i++) {
+        motion_dir[i] = (i > 10 && i < 40) ? 0.5f + sinf(0.3f * i) : 0.0f;
+        dot += motion_dir[i] * static_profile[i];
+        energy += static_profile[i] * static_profile[i];
+    }
+    float norm = 0.0f;
+    for (int i = 0; i < NSC; i++) {
+        motion_dir[i] -= dot / energy * static_profile[i];
+        norm += motion_dir[i] * motion_dir[i];
+    }
+    for (int i = 0; i < NSC; i++) motion_dir[i] /= sqrtf(norm);
+}
+
+// Amplitude moves along motion_dir at the link's tone, phase is random
+static void make_frame(int link, int t, int8_t *csi)
+{
+    float motion = MOTION_AMPLITUDE * sinf(2.0f * (float)M_PI * link_tone_hz(link) * t / FRAME_RATE_HZ);
+    for (int i = 0; i < FRAME_BYTES / 2; i++) {
+        float amp = static_profile[i] + (i < NSC ? motion * motion_dir[i] : 0.0f) + (rand() % 100) / 50.0f;
+        float theta = (rand() % 628) / 100.0f;
+        csi[2 * i] = (int8_t)lrintf(amp * cosf(theta));
+        csi[2 * i + 1] = (int8_t)lrintf(amp * sinf(theta));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int links = argc > 1 ? atoi(argv[1]) : 64;
+    csi_spec_config_t cfg = {
+        .nfft = argc > 2 ? atoi(argv[2]) : 256,
+        .hop = argc > 3 ? atoi(argv[3]) : 25,
+        .components = argc > 4 ? atoi(argv[4]) : 4,
+    };
+    float seconds = argc > 5 ? (float)atof(argv[5]) : 30.0f;
+    int frames = (int)(seconds * FRAME_RATE_HZ);
+
+    csi_spectrogram_t *s = csi_spectrogram_create(&cfg, links);
+    if (!s) {
+        fprintf(stderr, "invalid configuration\n");
+        return 1;
+    }
+    int feature_size = csi_spectrogram_feature_size(s);
+    float *features = malloc(feature_size * sizeof(float));
+
+    // Pre-generate input so only the engine is timed
+    srand(7310);
+    make_directions();
+    int8_t *input = malloc((size_t)links * frames * FRAME_BYTES);
+    if (!features || !input) return 1;
+    for (int t = 0; t < frames; t++) {
+        for (int l = 0; l < links; l++) {
+            make_frame(l, t, &input[((size_t)t * links + l) * FRAME_BYTES]);
+        }
+    }
+
+    long emitted = 0;
+    int peak_ok = 0, peak_checked = 0;
+    int aligned = 0;
+    float worst_alignment = 1.0f;
+    int bins = cfg.nfft / 2 + 1;
+    double t0 = now_s();
+    for (int t = 0; t < frames; t++) {
+        for (int l = 0; l < links; l++) {
+            const int8_t *csi = &input[((size_t)t * links + l) * FRAME_BYTES];
+            if (csi_spectrogram_push(s, l, csi, FRAME_BYTES, features) != 1) continue;
+            emitted++;
+
+            const float *pc1 = csi_spectrogram_basis(s, l, 0);
+            float alignment = 0.0f;
+            for (int i = 0; i < NSC; i++) alignment += pc1[i] * motion_dir[i];
+            alignment = fabsf(alignment);
+            aligned += alignment >= MIN_ALIGNMENT;
+            if (alignment < worst_alignment) worst_alignment = alignment;
+
+            // Strongest non-DC bin of the first component should sit on the link's tone
+            int peak = 1;
+            for (int b = 2; b < bins; b++) {
+                if (features[b] > features[peak]) peak = b;
+            }
+            float expected = link_tone_hz(l) * cfg.nfft / FRAME_RATE_HZ;
+            peak_checked++;
+            peak_ok += fabsf(peak - expected) <= 1.0f;
+        }
+    }
+    double elapsed = now_s() - t0;
+
+    double frame_rate = (double)links * frames / elapsed;
+    printf("links %d, nfft %d, hop %d, components %d, %d frames per link (%.0f s at %.0f Hz)\n",
+           links, cfg.nfft, cfg.hop, cfg.components, frames, seconds, FRAME_RATE_HZ);
+    printf("feature frame: %d floats, %ld emitted\n", feature_size, emitted);
+    printf("throughput: %.0f frames/s, %.2f us/frame, real-time factor %.1fx\n",
+           frame_rate, elapsed / ((double)links * frames) * 1e6, frame_rate / (links * FRAME_RATE_HZ));
+    printf("links sustainable at %.0f Hz on one core: %.0f\n", FRAME_RATE_HZ, frame_rate / FRAME_RATE_HZ);
+    printf("tone found in %d / %d feature frames\n", peak_ok, peak_checked);
+    printf("PC1 on the motion direction in %d / %ld feature frames (worst |<pc1, dir>| %.3f, need %.2f)\n",
+           aligned, emitted, worst_alignment, MIN_ALIGNMENT);
+    int ok = emitted > 0 && aligned == emitted;
+
+    free(input);
+    free(features);
+    csi_spectrogram_destroy(s);
+    if (!ok) {
+        fprintf(stderr, "FAIL: principal component misses the planted motion direction\n");
+        return 1;
+    }
+    return 0;
+}
@@ -45,10 +45,14 @@
 #include "esp_mac.h"
 #include "rom/ets_sys.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "esp_wifi.h"
 #include "esp_netif.h"
 #include "esp_now.h"
 #include "mqtt_client.h"
+#include "csi_kernels.h"
+#include "csi_hampel.h"
+#include "csi_flash_log.h"
 
 
 
@@ -59,9 +63,23 @@ static float CSI_Q[CSI_BUFFER_LENGTH];
 static int CSI_Q_INDEX = 0; // CSI Buffer Index
 // Enable/Disable CSI Buffering. 1: Enable, using buffer, 0: Disable, using serial output
 static bool CSI_Q_ENABLE = 1; 
+// Enable/Disable the Hampel outlier filter on amplitudes before they enter CSI_Q. 1: Enable, 0: Disable
+static bool CSI_HAMPEL_ENABLE = 0;
+#define CSI_HAMPEL_WINDOW   9     // samples per subcarrier
+#define CSI_HAMPEL_SIGMAS   3.0f  // outlier threshold in robust standard deviations
+#define CSI_HAMPEL_MIN_DEV  2.0f  // residuals below this amplitude are never replaced
+static csi_hampel_t csi_hampel;
 static void csi_process(const int8_t *csi_data, int length);
 static esp_mqtt_client_handle_t mqtt_client = NULL;
 static bool mqtt_ready = false; 
+// Backlog PUBACK bookkeeping, shared by csi_log_task and the MQTT task under csi_log_ack_mux
+#define CSI_LOG_EARLY_ACKS 8
+static portMUX_TYPE csi_log_ack_mux = portMUX_INITIALIZER_UNLOCKED;
+static int csi_log_msg_id = -1;                           // backlog publish waiting for its PUBACK
+static int csi_log_ack = 0;                               // 1 acked, -1 deleted, 0 nothing yet
+static bool csi_log_enqueueing = false;                   // inside esp_mqtt_client_enqueue() for a batch
+static int csi_log_early_acks[CSI_LOG_EARLY_ACKS];        // PUBLISHED msg_ids seen meanwhile
+static int csi_log_early_count = 0;
 // [1] END OF YOUR CODE
 
 
@@ -83,6 +101,27 @@ static esp_err_t mqtt_event_handler_cb(esp_mqtt_event_handle_t event)
             mqtt_ready = false;
             ESP_LOGI("MQTT", "MQTT error");
             break;
+        case MQTT_EVENT_PUBLISHED:
+            // Only record the ack here; csi_log_task settles it, so this task never waits on flash.
+            // The PUBACK can beat csi_log_publish() storing the msg_id, so ids seen during the enqueue are kept.
+            portENTER_CRITICAL(&csi_log_ack_mux);
+            if (event->msg_id == csi_log_msg_id) {
+                csi_log_msg_id = -1;
+                csi_log_ack = 1;
+            } else if (csi_log_enqueueing && csi_log_early_count < CSI_LOG_EARLY_ACKS) {
+                csi_log_early_acks[csi_log_early_count++] = event->msg_id;
+            }
+            portEXIT_CRITICAL(&csi_log_ack_mux);
+            break;
+        case MQTT_EVENT_DELETED:
+            // Expired from the outbox without a PUBACK (CONFIG_MQTT_REPORT_DELETED_MESSAGES), send it again
+            portENTER_CRITICAL(&csi_log_ack_mux);
+            if (event->msg_id == csi_log_msg_id) {
+                csi_log_msg_id = -1;
+                csi_log_ack = -1;
+            }
+            portEXIT_CRITICAL(&csi_log_ack_mux);
+            break;
         default:
             break;
     }
@@ -123,30 +162,23 @@ void mqtt_app_start()
 #define STRIDE 50
 
 static const char *MOTION_TAG = "MotionDetect";
-static float amplitude_window[WINDOW_SIZE][NUM_SUBCARRIERS];
+static float window_sum[NUM_SUBCARRIERS];
+static float window_sum_sq[NUM_SUBCARRIERS];
 static int stride_counter = 0;
 
 bool motion_detection() {
+    // CSI_Q holds frames back to back, so accumulate whole frames instead of walking columns
     int start_idx = CSI_Q_INDEX - FRAME_LEN * WINDOW_SIZE;
+    memset(window_sum, 0, sizeof(window_sum));
+    memset(window_sum_sq, 0, sizeof(window_sum_sq));
     for (int w = 0; w < WINDOW_SIZE; w++) {
-        int base_idx = start_idx + w * FRAME_LEN;
-
-        for (int i = 0; i < NUM_SUBCARRIERS; i++) {
-            amplitude_window[w][i] = CSI_Q[base_idx + i];
-        }
+        csi_window_accumulate_f32(&CSI_Q[start_idx + w * FRAME_LEN], window_sum, window_sum_sq, NUM_SUBCARRIERS);
     }
 
     float std_sum = 0.0f;
     for (int i = 0; i < NUM_SUBCARRIERS; i++) {
-        float sum = 0.0f;
-        float sum_sq = 0.0f;
-        for (int j = 0; j < WINDOW_SIZE; j++) {
-            float val = amplitude_window[j][i];
-            sum += val;
-            sum_sq += val * val;
-        }
-        float mean = sum / WINDOW_SIZE;
-        float variance = (sum_sq / WINDOW_SIZE) - (mean * mean);
+        float mean = window_sum[i] / WINDOW_SIZE;
+        float variance = (window_sum_sq[i] / WINDOW_SIZE) - (mean * mean);
         std_sum += sqrtf(variance);
     }
 
@@ -169,10 +201,96 @@ int breathing_rate_estimation() {
     return 0; // Placeholder
 }
 
+// Store-and-forward: while MQTT is down, CSI frames and results are staged in RAM by the CSI callback,
+// written to the csi_log flash partition by a low-priority task, and published by the same task in
+// batches once MQTT is back. A batch is marked drained when its PUBACK arrives (at-least-once).
+// The client expires unacked messages from its outbox after 30 s and reports them as MQTT_EVENT_DELETED,
+// which resends the batch; CSI_LOG_ACK_TIMEOUT_MS (60 s) is only the backstop for a lost event.
+#define CSI_LOG_BATCH_BYTES      CSI_LOG_MAX_BATCH_BYTES  // bytes per backlog publish
+#define CSI_LOG_TASK_PERIOD_MS   100    // flush / drain period, the RAM staging ring holds ~0.6 s of frames
+#define CSI_LOG_STATS_PERIOD_MS  10000
+static bool csi_log_ready = false;
+
+static esp_err_t csi_log_publish(const uint8_t *batch, size_t len, uint32_t records)
+{
+    if (!mqtt_client || !mqtt_ready) return ESP_FAIL;
+    // The enqueue cannot run inside the critical section, so PUBLISHED ids seen while it runs are
+    // collected and matched once the msg_id is known
+    portENTER_CRITICAL(&csi_log_ack_mux);
+    csi_log_msg_id = -1;
+    csi_log_ack = 0;
+    csi_log_early_count = 0;
+    csi_log_enqueueing = true;
+    portEXIT_CRITICAL(&csi_log_ack_mux);
+
+    // Queued in the client outbox, MQTT_EVENT_PUBLISHED for this msg_id acks the batch
+    int msg_id = esp_mqtt_client_enqueue(mqtt_client, "/esp32/csi/backlog", (const char *)batch, len, 1, 0, true);
+
+    portENTER_CRITICAL(&csi_log_ack_mux);
+    csi_log_enqueueing = false;
+    if (msg_id >= 0) {
+        csi_log_msg_id = msg_id;
+        for (int i = 0; i < csi_log_early_count; i++) {
+            if (csi_log_early_acks[i] == msg_id) {
+                csi_log_msg_id = -1;
+                csi_log_ack = 1;
+            }
+        }
+    }
+    portEXIT_CRITICAL(&csi_log_ack_mux);
+    if (msg_id < 0) return ESP_FAIL;
+    ESP_LOGI("MQTT", "📤 Backlog queued: %u records, %u bytes (msg_id=%d)", (unsigned)records, (unsigned)len, msg_id);
+    return ESP_OK;
+}
+
+static void csi_log_task(void *arg)
+{
+    csi_flash_log_stats_t last = {0};
+    int elapsed_ms = 0;
+    while (true) {
+        portENTER_CRITICAL(&csi_log_ack_mux);
+        int ack = csi_log_ack;
+        csi_log_ack = 0;
+        portEXIT_CRITICAL(&csi_log_ack_mux);
+        if (ack != 0) {
+            csi_flash_log_drain_ack(ack > 0);
+        }
+
+        csi_flash_log_flush();
+        if (mqtt_ready && csi_flash_log_pending() > 0) {
+            csi_flash_log_drain(csi_log_publish, CSI_LOG_BATCH_BYTES);
+        }
+        vTaskDelay(pdMS_TO_TICKS(CSI_LOG_TASK_PERIOD_MS));
+
+        elapsed_ms += CSI_LOG_TASK_PERIOD_MS;
+        if (elapsed_ms >= CSI_LOG_STATS_PERIOD_MS) {
+            csi_flash_log_stats_t now;
+            csi_flash_log_get_stats(&now);
+            uint32_t written = now.bytes_written - last.bytes_written;
+            uint32_t write_us = now.write_time_us - last.write_time_us;
+            ESP_LOGI("CSI_LOG", "pending %u | write %u B/s (flash busy %u%%, %u KB/s while busy) | "
+                     "erases %u (%.2f per sector) | drained %u B/s | dropped %u (staging %u)",
+                     (unsigned)now.pending, (unsigned)(written * 1000u / elapsed_ms),
+                     (unsigned)(write_us / (elapsed_ms * 10u)), (unsigned)(write_us ? written * 1000u / write_us : 0),
+                     (unsigned)now.sector_erases, (float)now.sector_erases / now.sector_count,
+                     (unsigned)((now.bytes_drained - last.bytes_drained) * 1000u / elapsed_ms),
+                     (unsigned)now.records_dropped, (unsigned)now.stage_dropped);
+            last = now;
+            elapsed_ms = 0;
+        }
+    }
+}
+
 void mqtt_send(bool motion_result, int breathing_rate) {
     // TODO: Implement MQTT message sending using CSI data or Results
     // NOTE: If you implement the algorithm on-board, you can return the results to the host, else send the CSI data.
-    if (!mqtt_client || !mqtt_ready) return;
+    if (!mqtt_client || !mqtt_ready) {
+        if (csi_log_ready) {
+            csi_log_result_t result = { .motion = motion_result, .breathing_rate = breathing_rate };
+            csi_flash_log_append(CSI_LOG_TYPE_RESULT, &result, sizeof(result));
+        }
+        return;
+    }
 
     // construct the CSV payload
     // char payload[2048]; 
@@ -262,6 +380,20 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
                              int32_t event_id, void* event_data);
 static bool wifi_connected = false;
 
+// Reconnect with back-off and wait on the CSI channel in between, so frames from the sender keep
+// reaching csi_process() (and the flash log) while the AP is down. Each attempt still scans the other
+// channels for a moment, so a little CSI is lost per attempt.
+#define WIFI_RECONNECT_MIN_MS 1000
+#define WIFI_RECONNECT_MAX_MS 30000
+static esp_timer_handle_t wifi_reconnect_timer = NULL;
+static uint32_t wifi_reconnect_ms = WIFI_RECONNECT_MIN_MS;
+
+static void wifi_reconnect_cb(void *arg)
+{
+    ESP_LOGI(TAG, "Trying to connect to AP...");
+    esp_wifi_connect();
+}
+
 //------------------------------------------------------WiFi Initialize------------------------------------------------------
 static void wifi_init()
 {
@@ -275,6 +407,12 @@ static void wifi_init()
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
     ESP_ERROR_CHECK(esp_wifi_set_storage(WIFI_STORAGE_RAM));
 
+    const esp_timer_create_args_t reconnect_args = {
+        .callback = wifi_reconnect_cb,
+        .name = "wifi_reconnect",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&reconnect_args, &wifi_reconnect_timer));
+
     esp_event_handler_instance_t instance_any_id;
     esp_event_handler_instance_t instance_got_ip;
     ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT,
@@ -320,13 +458,16 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
         ESP_LOGI(TAG, "Trying to connect to AP...");
         esp_wifi_connect();
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
-        ESP_LOGI(TAG, "Connection failed! Retrying...");
         wifi_connected = false;
-        esp_wifi_connect();
+        esp_wifi_set_channel(CONFIG_LESS_INTERFERENCE_CHANNEL, WIFI_SECOND_CHAN_NONE);
+        ESP_LOGI(TAG, "Connection failed! Retrying in %u ms...", (unsigned)wifi_reconnect_ms);
+        esp_timer_start_once(wifi_reconnect_timer, (uint64_t)wifi_reconnect_ms * 1000);
+        wifi_reconnect_ms = wifi_reconnect_ms * 2 > WIFI_RECONNECT_MAX_MS ? WIFI_RECONNECT_MAX_MS : wifi_reconnect_ms * 2;
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
         ESP_LOGI(TAG, "Got IP:" IPSTR, IP2STR(&event->ip_info.ip));
         wifi_connected = true;
+        wifi_reconnect_ms = WIFI_RECONNECT_MIN_MS;
         
         wifi_ap_record_t ap_info;
         if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
@@ -360,18 +501,6 @@ static void wifi_csi_rx_cb(void *ctx, wifi_csi_info_t *info)
 
     ESP_LOGI(TAG, "CSI callback triggered");
 
-    // Applying the CSI_Q_ENABLE flag to determine the output method
-    // 1: Enable, using buffer, 0: Disable, using serial output
-    if (!CSI_Q_ENABLE) {
-        ets_printf("CSI_DATA,%d," MACSTR ",%d,%d,%d,%d\n",
-                   info->len, MAC2STR(info->mac), info->rx_ctrl.rssi,
-                   info->rx_ctrl.rate, info->rx_ctrl.noise_floor,
-                   info->rx_ctrl.channel);
-    } else {
-        csi_process(info->buf, info->len);
-    }
-
-    
     if (!info || !info->buf) {
         ESP_LOGW(TAG, "<%s> wifi_csi_cb", esp_err_to_name(ESP_ERR_INVALID_ARG));
         return;
@@ -407,6 +536,8 @@ static void wifi_csi_rx_cb(void *ctx, wifi_csi_info_t *info)
     }
 #endif
 
+    // Applying the CSI_Q_ENABLE flag to determine the output method, once per accepted frame
+    // 1: Enable, using buffer, 0: Disable, using serial output
     const wifi_pkt_rx_ctrl_t *rx_ctrl = &info->rx_ctrl;
     if (CSI_Q_ENABLE == 0) {
         ESP_LOGI(TAG, "================ CSI RECV via Serial Port ================");
@@ -439,14 +570,25 @@ static void csi_process(const int8_t *csi_data, int length)
     }    
    
     // Append new CSI data to the buffer
-    for (int i = 0; i + 1 < length && CSI_Q_INDEX < CSI_BUFFER_LENGTH; i += 2) {
-        int16_t imag = (int16_t)csi_data[i];
-        int16_t real = (int16_t)csi_data[i + 1];
-        float amplitude = sqrtf(imag * imag + real * real);
-        CSI_Q[CSI_Q_INDEX++] = amplitude;
+    int n_pairs = length / 2;
+    if (n_pairs > CSI_BUFFER_LENGTH - CSI_Q_INDEX) {
+        n_pairs = CSI_BUFFER_LENGTH - CSI_Q_INDEX;
     }
+    csi_amplitude_f32(csi_data, &CSI_Q[CSI_Q_INDEX], n_pairs);
+    if (CSI_HAMPEL_ENABLE) {
+        int replaced = csi_hampel_process_frame(&csi_hampel, &CSI_Q[CSI_Q_INDEX], n_pairs);
+        if (replaced > 0) {
+            ESP_LOGI(TAG, "Hampel filter replaced %d samples (%u total)", replaced, (unsigned)csi_hampel.replaced);
+        }
+    }
+    CSI_Q_INDEX += n_pairs;
 
     ESP_LOGI(TAG, "CSI Buffer Status: %d samples stored", CSI_Q_INDEX);
+
+    // Keep the raw frame while it cannot be sent; this only stages it in RAM, csi_log_task writes it to flash
+    if (csi_log_ready && !mqtt_ready) {
+        csi_flash_log_append(CSI_LOG_TYPE_FRAME, csi_data, length);
+    }
     // [4] YOUR CODE HERE
 
     // 1. Fill the information of your group members
@@ -546,6 +688,16 @@ void app_main()
     }
     ESP_ERROR_CHECK(ret);
 
+    /**
+     * @brief Initialize the store-and-forward log
+     */
+    csi_log_ready = csi_flash_log_init() == ESP_OK;
+    if (csi_log_ready) {
+        xTaskCreate(csi_log_task, "csi_log", 4096, NULL, tskIDLE_PRIORITY + 1, NULL);
+    } else {
+        ESP_LOGW(TAG, "Flash log unavailable, CSI is dropped while MQTT is down");
+    }
+
     /**
      * @brief Initialize Wi-Fi
      */
@@ -578,7 +730,11 @@ void app_main()
      * @brief Initialize ESP-NOW
      */
 
-    if (wifi_connected) {
+    if (!wifi_connected && csi_log_ready) {
+        ESP_LOGW(TAG, "WiFi connection failed, storing CSI in flash until MQTT connects");
+    }
+
+    if (wifi_connected || csi_log_ready) {
          // ================= MQTT initialize =================
          mqtt_app_start(); // Initialize MQTT Client
 
@@ -591,6 +747,8 @@ void app_main()
         };
 
         wifi_esp_now_init(peer); // Initialize ESP-NOW Communication
+        ESP_LOGI(TAG, "CSI kernel backend: %s", csi_kernels_backend());
+        csi_hampel_init(&csi_hampel, CSI_HAMPEL_WINDOW, CSI_HAMPEL_SIGMAS, CSI_HAMPEL_MIN_DEV);
         wifi_csi_init(); // Initialize CSI Collection
 
     } else {
@@ -0,0 +1,433 @@
+/* CSI Flash Log
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdbool.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_timer.h"
+#include "csi_flash_log.h"
+
+#define CSI_LOG_MAGIC 0x4C495343 // "CSIL"
+#define SECTOR_HDR_SIZE sizeof(csi_log_sector_hdr_t)
+#define RECORD_HDR_SIZE sizeof(csi_log_record_hdr_t)
+#define STAGE_BYTES 8192        // RAM ring between the CSI callback and the writer task, ~0.6 s of frames
+#define WRITE_BATCH_BYTES 1024  // largest single flash write, a few 256-byte pages
+
+static const char *LOG_TAG = "csi_flash_log";
+
+static const esp_partition_t *log_part = NULL;
+static SemaphoreHandle_t log_lock = NULL;
+static uint32_t sec_size;
+static uint32_t sec_count;
+static uint32_t head_off;  // where the next record is written
+static uint32_t tail_off;  // oldest undrained record, or head_off when empty
+static uint32_t head_seq;  // seq of the sector holding head_off
+static csi_flash_log_stats_t log_stats;
+
+// Staged records, complete with headers; only touched inside stage_mux
+static portMUX_TYPE stage_mux = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t stage[STAGE_BYTES];
+static uint32_t stage_head;     // next free byte
+static uint32_t stage_fill;     // bytes in use
+static uint32_t stage_dropped;
+static uint8_t write_buf[WRITE_BATCH_BYTES];  // writer task only
+static uint8_t drain_buf[CSI_LOG_MAX_BATCH_BYTES];  // writer task only, handed to the sink
+
+// The one drained batch waiting for its ack
+static struct {
+    bool active;
+    uint32_t start;     // tail_off when the batch was built
+    uint32_t next;      // first record after the batch
+    uint32_t last;      // last record of the batch, marked drained on ack
+    uint32_t records;
+    uint32_t bytes;
+    int64_t sent_us;
+} inflight;
+
+//------------------------------------------------------Layout Helpers------------------------------------------------------
+static inline uint32_t record_size(uint16_t len)
+{
+    return RECORD_HDR_SIZE + ((len + 3u) & ~3u);
+}
+
+static inline uint32_t sector_of(uint32_t off)
+{
+    return off / sec_size;
+}
+
+// head_off may sit exactly on the end of its sector
+static inline uint32_t head_sector(void)
+{
+    return sector_of(head_off - 1);
+}
+
+static inline uint32_t first_record(uint32_t sector)
+{
+    return (sector % sec_count) * sec_size + SECTOR_HDR_SIZE;
+}
+
+static bool read_sector_seq(uint32_t sector, uint32_t *seq)
+{
+    csi_log_sector_hdr_t hdr;
+    if (esp_partition_read(log_part, sector * sec_size, &hdr, sizeof(hdr)) != ESP_OK) return false;
+    if (hdr.magic != CSI_LOG_MAGIC) return false;
+    *seq = hdr.seq;
+    return true;
+}
+
+// True if a complete, committed record starts at `off`
+static bool read_record(uint32_t off, csi_log_record_hdr_t *hdr)
+{
+    uint32_t sector_end = (sector_of(off) + 1) * sec_size;
+    if (off + RECORD_HDR_SIZE > sector_end) return false;
+    if (esp_partition_read(log_part, off, hdr, sizeof(*hdr)) != ESP_OK) return false;
+    if (hdr->state != CSI_LOG_STATE_VALID && hdr->state != CSI_LOG_STATE_DRAINED) return false;
+    return off + record_size(hdr->len) <= sector_end;
+}
+
+// First record at or after `off`, skipping sector tails and headers; head_off if there is none
+static uint32_t log_seek(uint32_t off, csi_log_record_hdr_t *hdr)
+{
+    for (uint32_t hops = 0; hops <= sec_count; hops++) {
+        if (off == head_off) return off;
+        if (off >= sec_count * sec_size) off = 0;
+        if (off % sec_size == 0) off += SECTOR_HDR_SIZE;
+        if (off == head_off) return off;
+        if (read_record(off, hdr)) return off;
+        off = first_record(sector_of(off) + 1);
+    }
+    return head_off;
+}
+
+//------------------------------------------------------Staging Ring------------------------------------------------------
+static void stage_copy_in(const void *src, uint32_t n)
+{
+    uint32_t first = STAGE_BYTES - stage_head;
+    if (first > n) first = n;
+    memcpy(&stage[stage_head], src, first);
+    memcpy(stage, (const uint8_t *)src + first, n - first);
+    stage_head = (stage_head + n) % STAGE_BYTES;
+    stage_fill += n;
+}
+
+static void stage_copy_out(uint32_t from, void *dst, uint32_t n)
+{
+    uint32_t first = STAGE_BYTES - from;
+    if (first > n) first = n;
+    memcpy(dst, &stage[from], first);
+    memcpy((uint8_t *)dst + first, stage, n - first);
+}
+
+// Move whole records, oldest first, into `buf` up to `limit` bytes
+static uint32_t stage_take(uint8_t *buf, uint32_t limit, uint32_t *records, bool *more)
+{
+    uint32_t used = 0;
+    *records = 0;
+    portENTER_CRITICAL(&stage_mux);
+    uint32_t tail = (stage_head + STAGE_BYTES - stage_fill) % STAGE_BYTES;
+    while (used < stage_fill) {
+        csi_log_record_hdr_t hdr;
+        stage_copy_out((tail + used) % STAGE_BYTES, &hdr, sizeof(hdr));
+        uint32_t size = record_size(hdr.len);
+        if (used + size > limit) break;
+        stage_copy_out((tail + used) % STAGE_BYTES, buf + used, size);
+        used += size;
+        (*records)++;
+    }
+    stage_fill -= used;
+    *more = stage_fill > 0;
+    portEXIT_CRITICAL(&stage_mux);
+    return used;
+}
+
+//------------------------------------------------------Sector Rotation------------------------------------------------------
+static esp_err_t start_sector(uint32_t sector, uint32_t seq)
+{
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = esp_partition_erase_range(log_part, sector * sec_size, sec_size);
+    if (err == ESP_OK) {
+        csi_log_sector_hdr_t hdr = { .magic = CSI_LOG_MAGIC, .seq = seq };
+        err = esp_partition_write(log_part, sector * sec_size, &hdr, sizeof(hdr));
+    }
+    log_stats.write_time_us += (uint32_t)(esp_timer_get_time() - t0);
+    log_stats.sector_erases++;
+    return err;
+}
+
+// Move the head to the next sector, dropping that sector's undrained records if the ring is full
+static esp_err_t advance_head(void)
+{
+    uint32_t next = (head_sector() + 1) % sec_count;
+    bool empty = tail_off == head_off;
+
+    if (!empty) {
+        csi_log_record_hdr_t hdr;
+        uint32_t off = log_seek(tail_off, &hdr);
+        uint32_t dropped = 0;
+        while (off != head_off && sector_of(off) == next) {
+            dropped++;
+            off = log_seek(off + record_size(hdr.len), &hdr);
+        }
+        if (dropped > 0) {
+            log_stats.records_dropped += dropped;
+            log_stats.pending -= dropped;
+            tail_off = off;
+            ESP_LOGW(LOG_TAG, "Log full, dropped %u oldest records", (unsigned)dropped);
+        }
+    }
+
+    esp_err_t err = start_sector(next, head_seq + 1);
+    if (err != ESP_OK) return err;
+    head_seq++;
+    head_off = first_record(next);
+    if (empty || log_stats.pending == 0) tail_off = head_off;
+    return ESP_OK;
+}
+
+//------------------------------------------------------Public API------------------------------------------------------
+esp_err_t csi_flash_log_init(void)
+{
+    log_part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, CSI_LOG_PARTITION_LABEL);
+    if (!log_part) {
+        ESP_LOGE(LOG_TAG, "Partition \"%s\" not found", CSI_LOG_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+    sec_size = log_part->erase_size;
+    sec_count = log_part->size / sec_size;
+    if (sec_count < 2 || sec_size < SECTOR_HDR_SIZE + WRITE_BATCH_BYTES) return ESP_ERR_INVALID_SIZE;
+
+    log_lock = xSemaphoreCreateMutex();
+    if (!log_lock) return ESP_ERR_NO_MEM;
+    memset(&log_stats, 0, sizeof(log_stats));
+    log_stats.sector_count = sec_count;
+    memset(&inflight, 0, sizeof(inflight));
+    portENTER_CRITICAL(&stage_mux);
+    stage_head = stage_fill = stage_dropped = 0;
+    portEXIT_CRITICAL(&stage_mux);
+
+    // The newest sector holds the head, the oldest is found by walking back through consecutive seqs
+    uint32_t newest = 0, seq = 0;
+    bool found = false;
+    for (uint32_t s = 0; s < sec_count; s++) {
+        uint32_t sseq;
+        if (read_sector_seq(s, &sseq) && (!found || (int32_t)(sseq - head_seq) > 0)) {
+            newest = s;
+            head_seq = sseq;
+            found = true;
+        }
+    }
+    if (!found) {
+        head_seq = 1;
+        head_off = tail_off = first_record(0);
+        ESP_LOGI(LOG_TAG, "Empty log, %u sectors of %u bytes", (unsigned)sec_count, (unsigned)sec_size);
+        return start_sector(0, head_seq);
+    }
+
+    uint32_t oldest = newest;
+    seq = head_seq;
+    for (uint32_t n = 1; n < sec_count; n++) {
+        uint32_t prev = (oldest + sec_count - 1) % sec_count;
+        uint32_t pseq;
+        if (!read_sector_seq(prev, &pseq) || pseq != seq - 1) break;
+        oldest = prev;
+        seq = pseq;
+    }
+
+    // Head: end of the committed records in the newest sector
+    csi_log_record_hdr_t hdr;
+    uint32_t off = first_record(newest);
+    while (read_record(off, &hdr)) {
+        off += record_size(hdr.len);
+    }
+    head_off = off;
+
+    // Tail: right after the last record marked drained
+    tail_off = first_record(oldest);
+    off = log_seek(tail_off, &hdr);
+    while (off != head_off) {
+        uint32_t next = off + record_size(hdr.len);
+        if (hdr.state == CSI_LOG_STATE_DRAINED) {
+            tail_off = next;
+            log_stats.pending = 0;
+        } else {
+            log_stats.pending++;
+        }
+        off = log_seek(next, &hdr);
+    }
+    tail_off = log_seek(tail_off, &hdr);
+
+    ESP_LOGI(LOG_TAG, "Recovered log: %u pending records, head sector %u (seq %u), %u sectors",
+             (unsigned)log_stats.pending, (unsigned)newest, (unsigned)head_seq, (unsigned)sec_count);
+
+    // Space after the head may hold a partial write from a power loss, so continue in a fresh sector
+    return advance_head();
+}
+
+esp_err_t csi_flash_log_append(uint8_t type, const void *data, uint16_t len)
+{
+    if (!log_part) return ESP_ERR_INVALID_STATE;
+    uint32_t size = record_size(len);
+    if (size > WRITE_BATCH_BYTES) return ESP_ERR_INVALID_SIZE;
+
+    csi_log_record_hdr_t hdr = {
+        .state = CSI_LOG_STATE_VALID,
+        .type = type,
+        .len = len,
+        .time_ms = (uint32_t)(esp_timer_get_time() / 1000),
+    };
+    static const uint8_t pad[3] = { 0xFF, 0xFF, 0xFF };
+
+    esp_err_t err = ESP_OK;
+    portENTER_CRITICAL(&stage_mux);
+    if (stage_fill + size > STAGE_BYTES) {
+        stage_dropped++;
+        err = ESP_ERR_NO_MEM;
+    } else {
+        stage_copy_in(&hdr, sizeof(hdr));
+        stage_copy_in(data, len);
+        stage_copy_in(pad, size - sizeof(hdr) - len);
+    }
+    portEXIT_CRITICAL(&stage_mux);
+    return err;
+}
+
+esp_err_t csi_flash_log_flush(void)
+{
+    if (!log_part) return ESP_ERR_INVALID_STATE;
+    esp_err_t err = ESP_OK;
+    bool more = true;
+
+    xSemaphoreTake(log_lock, portMAX_DELAY);
+    while (more) {
+        uint32_t room = (head_sector() + 1) * sec_size - head_off;
+        uint32_t records;
+        uint32_t used = stage_take(write_buf, room < WRITE_BATCH_BYTES ? room : WRITE_BATCH_BYTES, &records, &more);
+        if (used == 0) {
+            // The next record does not fit in what is left of this sector
+            if (more) err = advance_head();
+            if (err != ESP_OK) break;
+            continue;
+        }
+
+        // The batch only becomes visible when the first record's state is written, after everything else
+        uint8_t state = write_buf[0];
+        write_buf[0] = 0xFF;
+        int64_t t0 = esp_timer_get_time();
+        err = esp_partition_write(log_part, head_off, write_buf, used);
+        if (err == ESP_OK) {
+            err = esp_partition_write(log_part, head_off, &state, 1);
+        }
+        log_stats.write_time_us += (uint32_t)(esp_timer_get_time() - t0);
+        if (err != ESP_OK) {
+            // The space after the head is no longer clean, so later records go to a fresh sector
+            ESP_LOGE(LOG_TAG, "Flash write failed: %s", esp_err_to_name(err));
+            log_stats.records_dropped += records;
+            advance_head();
+            break;
+        }
+        head_off += used;
+        log_stats.records_written += records;
+        log_stats.bytes_written += used;
+        log_stats.write_batches++;
+        log_stats.pending += records;
+    }
+    xSemaphoreGive(log_lock);
+    return err;
+}
+
+int csi_flash_log_drain(csi_flash_log_sink_t sink, size_t max_bytes)
+{
+    if (!log_part || csi_flash_log_pending() == 0) return 0;
+    if (max_bytes > sizeof(drain_buf)) max_bytes = sizeof(drain_buf);
+
+    // Copy a batch out under the lock, publish without it so the writer task is never blocked on the network
+    xSemaphoreTake(log_lock, portMAX_DELAY);
+    if (inflight.active) {
+        if (esp_timer_get_time() - inflight.sent_us < (int64_t)CSI_LOG_ACK_TIMEOUT_MS * 1000) {
+            xSemaphoreGive(log_lock);
+            return 0;
+        }
+        ESP_LOGW(LOG_TAG, "No ack for %u records, sending them again", (unsigned)inflight.records);
+        inflight.active = false;
+        log_stats.drain_timeouts++;
+    }
+    uint32_t off = tail_off, last = 0, records = 0;
+    size_t used = 0;
+    csi_log_record_hdr_t hdr;
+    while ((off = log_seek(off, &hdr)) != head_off) {
+        uint32_t size = record_size(hdr.len);
+        if (used + size > max_bytes) break;
+        if (esp_partition_read(log_part, off, drain_buf + used, size) != ESP_OK) break;
+        used += size;
+        last = off;
+        records++;
+        off += size;
+    }
+    if (records > 0) {
+        inflight.active = true;
+        inflight.start = tail_off;
+        inflight.next = off;
+        inflight.last = last;
+        inflight.records = records;
+        inflight.bytes = used;
+        inflight.sent_us = esp_timer_get_time();
+    }
+    xSemaphoreGive(log_lock);
+
+    if (records > 0 && sink(drain_buf, used, records) != ESP_OK) {
+        csi_flash_log_drain_ack(false);
+        records = 0;
+    }
+    return records;
+}
+
+void csi_flash_log_drain_ack(bool delivered)
+{
+    if (!log_part) return;
+    xSemaphoreTake(log_lock, portMAX_DELAY);
+    // Skip the bookkeeping if a wrap-around dropped these records meanwhile
+    if (inflight.active && delivered && tail_off == inflight.start) {
+        uint8_t state = CSI_LOG_STATE_DRAINED;
+        csi_log_record_hdr_t hdr;
+        esp_partition_write(log_part, inflight.last, &state, 1);
+        tail_off = log_seek(inflight.next, &hdr);
+        log_stats.pending -= inflight.records;
+        log_stats.records_drained += inflight.records;
+        log_stats.bytes_drained += inflight.bytes;
+        log_stats.drain_batches++;
+    }
+    inflight.active = false;
+    xSemaphoreGive(log_lock);
+}
+
+uint32_t csi_flash_log_pending(void)
+{
+    if (!log_part) return 0;
+    xSemaphoreTake(log_lock, portMAX_DELAY);
+    uint32_t pending = log_stats.pending;
+    xSemaphoreGive(log_lock);
+    return pending;
+}
+
+void csi_flash_log_get_stats(csi_flash_log_stats_t *stats)
+{
+    if (!log_part) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    xSemaphoreTake(log_lock, portMAX_DELAY);
+    *stats = log_stats;
+    xSemaphoreGive(log_lock);
+    portENTER_CRITICAL(&stage_mux);
+    stats->stage_dropped = stage_dropped;
+    portEXIT_CRITICAL(&stage_mux);
+}
@@ -0,0 +1,147 @@
+/* CSI Flash Log
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/**
+ * Store-and-forward log for CSI frames and detection results.
+ *
+ * Records are appended to the "csi_log" data partition (see partitions.csv),
+ * which is used as a circular log of erase sectors. Writes are strictly
+ * sequential and each sector is erased only when the head wraps onto it, so
+ * every sector sees the same number of erase cycles. When the log is full the
+ * oldest sector is dropped.
+ *
+ * csi_flash_log_append() only copies the record into a RAM staging ring, so it
+ * can be called from the Wi-Fi CSI callback. A writer task calls
+ * csi_flash_log_flush() to move staged records to flash in page-sized batches;
+ * all erases happen there.
+ *
+ * Layout:
+ *   sector = csi_log_sector_hdr_t, then records back to back
+ *   record = csi_log_record_hdr_t, then `len` payload bytes, padded to 4 bytes
+ *
+ * Drained batches are the raw record bytes (header + padded payload), in order.
+ * A batch stays pending until csi_flash_log_drain_ack() confirms it, so delivery
+ * is at-least-once: a batch whose ack is lost is sent again.
+ *
+ * The log survives a reboot: csi_flash_log_init() finds the head and the first
+ * undrained record by scanning the partition.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CSI_LOG_PARTITION_LABEL "csi_log"
+
+#define CSI_LOG_ACK_TIMEOUT_MS 60000  // twice the esp-mqtt outbox expiry, so the client reports a lost batch first
+#define CSI_LOG_MAX_BATCH_BYTES 4096  // largest drained batch, the drain buffer is static
+
+#define CSI_LOG_TYPE_FRAME  1  // payload: raw int8 I/Q CSI buffer
+#define CSI_LOG_TYPE_RESULT 2  // payload: csi_log_result_t
+
+#define CSI_LOG_STATE_VALID   0xFE
+#define CSI_LOG_STATE_DRAINED 0xFC  // set on the last record of each drained batch
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;        /**< increases by one every time a sector is (re)started */
+} csi_log_sector_hdr_t;
+
+typedef struct {
+    uint8_t state;       /**< CSI_LOG_STATE_*, 0xFF means free space */
+    uint8_t type;        /**< CSI_LOG_TYPE_* */
+    uint16_t len;        /**< payload length in bytes */
+    uint32_t time_ms;    /**< milliseconds since boot when the record was written */
+} csi_log_record_hdr_t;
+
+typedef struct {
+    int16_t motion;
+    int16_t breathing_rate;
+} csi_log_result_t;
+
+typedef struct {
+    uint32_t records_written;
+    uint32_t bytes_written;
+    uint32_t write_time_us;    /**< time spent in flash erase + write */
+    uint32_t sector_erases;
+    uint32_t write_batches;    /**< flash writes made by csi_flash_log_flush() */
+    uint32_t sector_count;
+    uint32_t records_dropped;  /**< lost to wrap-around before they were drained */
+    uint32_t stage_dropped;    /**< lost because the RAM staging ring was full */
+    uint32_t records_drained;
+    uint32_t bytes_drained;
+    uint32_t drain_batches;
+    uint32_t drain_timeouts;   /**< batches resent because no ack arrived */
+    uint32_t pending;          /**< records waiting to be drained */
+} csi_flash_log_stats_t;
+
+/**
+ * @brief Publish one batch of drained records
+ * @return ESP_OK if the batch was handed to the transport; it is marked as
+ *         drained only once csi_flash_log_drain_ack() confirms delivery
+ */
+typedef esp_err_t (*csi_flash_log_sink_t)(const uint8_t *batch, size_t len, uint32_t records);
+
+/**
+ * @brief Open the csi_log partition and recover head / tail from its contents
+ */
+esp_err_t csi_flash_log_init(void);
+
+/**
+ * @brief Stage a record in RAM for the writer task, never blocks or touches flash
+ * @return ESP_ERR_NO_MEM if the staging ring is full and the record was dropped
+ */
+esp_err_t csi_flash_log_append(uint8_t type, const void *data, uint16_t len);
+
+/**
+ * @brief Write staged records to flash, erasing sectors as the head advances
+ *
+ * Call from a single writer task. The oldest sector is dropped if the log is full.
+ */
+esp_err_t csi_flash_log_flush(void);
+
+/**
+ * @brief Send the oldest undrained records as one batch
+ *
+ * Call from the writer task that calls csi_flash_log_flush(). Only one batch
+ * is in flight at a time. A batch not acked within CSI_LOG_ACK_TIMEOUT_MS is
+ * abandoned and sent again.
+ *
+ * @param[in] sink called with the batch, outside the log lock; the buffer is only valid during the call
+ * @param[in] max_bytes largest batch to build, at least one record, at most CSI_LOG_MAX_BATCH_BYTES
+ * @return number of records sent, 0 if nothing was pending, a batch is in flight or the sink failed
+ */
+int csi_flash_log_drain(csi_flash_log_sink_t sink, size_t max_bytes);
+
+/**
+ * @brief Settle the batch in flight
+ * @param[in] delivered true to mark it drained, false to send it again
+ */
+void csi_flash_log_drain_ack(bool delivered);
+
+/**
+ * @brief Number of records waiting to be drained
+ */
+uint32_t csi_flash_log_pending(void);
+
+/**
+ * @brief Copy the write / wear / drain counters
+ */
+void csi_flash_log_get_stats(csi_flash_log_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
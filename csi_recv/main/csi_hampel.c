@@ -0,0 +1,179 @@
+/* CSI Hampel Filter
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+#include "csi_hampel.h"
+
+#define LO 0 // max-heap, values <= median
+#define HI 1 // min-heap, values >= median
+#define SIGMA_SCALE 1.4826f // median absolute residual to standard deviation for Gaussian noise
+
+//------------------------------------------------------Indexed Heaps------------------------------------------------------
+// heap[h][i] holds a ring slot and where[slot] points back at (h, i),
+// so the slot being overwritten can be re-sifted in place in O(log window).
+
+static inline bool heap_before(const csi_median_t *m, int h, int a, int b)
+{
+    return h == LO ? m->val[a] > m->val[b] : m->val[a] < m->val[b];
+}
+
+static inline void heap_set(csi_median_t *m, int h, int i, uint8_t slot)
+{
+    m->heap[h][i] = slot;
+    m->where[slot] = (uint8_t)((h << 7) | i);
+}
+
+static void heap_sift_up(csi_median_t *m, int h, int i)
+{
+    uint8_t slot = m->heap[h][i];
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!heap_before(m, h, slot, m->heap[h][parent])) break;
+        heap_set(m, h, i, m->heap[h][parent]);
+        i = parent;
+    }
+    heap_set(m, h, i, slot);
+}
+
+static void heap_sift_down(csi_median_t *m, int h, int i)
+{
+    uint8_t slot = m->heap[h][i];
+    int n = m->size[h];
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= n) break;
+        if (child + 1 < n && heap_before(m, h, m->heap[h][child + 1], m->heap[h][child])) {
+            child++;
+        }
+        if (!heap_before(m, h, m->heap[h][child], slot)) break;
+        heap_set(m, h, i, m->heap[h][child]);
+        i = child;
+    }
+    heap_set(m, h, i, slot);
+}
+
+static void heap_push(csi_median_t *m, int h, uint8_t slot)
+{
+    int i = m->size[h]++;
+    heap_set(m, h, i, slot);
+    heap_sift_up(m, h, i);
+}
+
+static uint8_t heap_pop(csi_median_t *m, int h)
+{
+    uint8_t top = m->heap[h][0];
+    int last = --m->size[h];
+    if (last > 0) {
+        heap_set(m, h, 0, m->heap[h][last]);
+        heap_sift_down(m, h, 0);
+    }
+    return top;
+}
+
+//------------------------------------------------------Sliding Median------------------------------------------------------
+void csi_median_init(csi_median_t *m, int window)
+{
+    memset(m, 0, sizeof(*m));
+    if (window < 1) window = 1;
+    if (window > CSI_HAMPEL_MAX_WINDOW) window = CSI_HAMPEL_MAX_WINDOW;
+    m->window = (uint8_t)window;
+}
+
+static float median_get(const csi_median_t *m)
+{
+    float lo = m->val[m->heap[LO][0]];
+    if (m->size[LO] > m->size[HI]) return lo;
+    return 0.5f * (lo + m->val[m->heap[HI][0]]);
+}
+
+float csi_median_push(csi_median_t *m, float x)
+{
+    uint8_t slot = m->head;
+    m->head = (uint8_t)((m->head + 1) % m->window);
+    m->val[slot] = x;
+
+    if (m->count < m->window) {
+        // Filling up: insert, then keep size[LO] == size[HI] or size[HI] + 1
+        m->count++;
+        if (m->size[LO] == 0 || x <= m->val[m->heap[LO][0]]) {
+            heap_push(m, LO, slot);
+        } else {
+            heap_push(m, HI, slot);
+        }
+        if (m->size[LO] > m->size[HI] + 1) {
+            heap_push(m, HI, heap_pop(m, LO));
+        } else if (m->size[HI] > m->size[LO]) {
+            heap_push(m, LO, heap_pop(m, HI));
+        }
+        return median_get(m);
+    }
+
+    // Full: the oldest slot was overwritten, re-sift it where it sits
+    int h = m->where[slot] >> 7;
+    int i = m->where[slot] & 0x7f;
+    heap_sift_up(m, h, i);
+    heap_sift_down(m, h, m->where[slot] & 0x7f);
+
+    // A single changed value can break the LO <= HI ordering by at most one swap of the tops
+    if (m->size[HI] > 0 && m->val[m->heap[LO][0]] > m->val[m->heap[HI][0]]) {
+        uint8_t lo_top = m->heap[LO][0];
+        uint8_t hi_top = m->heap[HI][0];
+        heap_set(m, LO, 0, hi_top);
+        heap_set(m, HI, 0, lo_top);
+        heap_sift_down(m, LO, 0);
+        heap_sift_down(m, HI, 0);
+    }
+    return median_get(m);
+}
+
+//------------------------------------------------------Hampel Filter------------------------------------------------------
+void csi_hampel_init(csi_hampel_t *f, int window, float n_sigmas, float min_dev)
+{
+    if (window < 1) window = 1;
+    if (window > CSI_HAMPEL_MAX_WINDOW) window = CSI_HAMPEL_MAX_WINDOW;
+    f->window = window;
+    f->n_sigmas = n_sigmas;
+    f->min_dev = min_dev;
+    f->samples = 0;
+    f->replaced = 0;
+    for (int i = 0; i < CSI_HAMPEL_MAX_CHANNELS; i++) {
+        csi_median_init(&f->ch[i].value, window);
+        csi_median_init(&f->ch[i].resid, window);
+    }
+}
+
+int csi_hampel_process_frame(csi_hampel_t *f, float *frame, int n)
+{
+    if (n > CSI_HAMPEL_MAX_CHANNELS) n = CSI_HAMPEL_MAX_CHANNELS;
+
+    int replaced = 0;
+    for (int i = 0; i < n; i++) {
+        csi_hampel_channel_t *ch = &f->ch[i];
+        float x = frame[i];
+        float med = csi_median_push(&ch->value, x);
+        float resid = fabsf(x - med);
+
+        // Judge against the scale of the previous residuals, so a spike cannot widen its own threshold
+        if (ch->resid.count == ch->resid.window) {
+            float limit = f->n_sigmas * SIGMA_SCALE * median_get(&ch->resid);
+            if (limit < f->min_dev) limit = f->min_dev;
+            if (resid > limit) {
+                frame[i] = med;
+                replaced++;
+            }
+        }
+        csi_median_push(&ch->resid, resid);
+    }
+
+    f->samples += n;
+    f->replaced += replaced;
+    return replaced;
+}
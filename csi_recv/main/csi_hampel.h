@@ -0,0 +1,97 @@
+/* CSI Hampel Filter
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/**
+ * Streaming per-subcarrier Hampel-style (median / residual scale) outlier filter.
+ *
+ * Each subcarrier keeps a trailing window of its last `window` amplitudes in
+ * two indexed heaps (max-heap below the median, min-heap above), so a new
+ * sample costs O(log window) instead of a sort per window.
+ *
+ * The scale is not the MAD of the current window. It is the median of the last
+ * `window` absolute residuals |x - median|, each taken against the window
+ * median at the time that sample arrived. They are kept in a second pair of
+ * heaps, so the scale is O(log window) as well. csi_host/hampel_bench.c
+ * compares this against a true median / MAD Hampel filter.
+ *
+ * A sample is replaced by the window median when its residual is larger than
+ * max(n_sigmas * 1.4826 * scale, min_dev). The filter is causal (no look-ahead)
+ * and does not touch samples until the residual window is full.
+ *
+ * All memory is static: see CSI_HAMPEL_MAX_WINDOW and CSI_HAMPEL_MAX_CHANNELS.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CSI_HAMPEL_MAX_WINDOW   15  // Largest supported window (samples per subcarrier)
+#define CSI_HAMPEL_MAX_CHANNELS 57  // HT20 LLTF subcarriers used by the receiver
+
+/**
+ * @brief Sliding median over the last `window` samples
+ */
+typedef struct {
+    float val[CSI_HAMPEL_MAX_WINDOW];                       /**< ring buffer of samples */
+    uint8_t heap[2][(CSI_HAMPEL_MAX_WINDOW + 1) / 2 + 1];  /**< slot ids, [0] max-heap (low half), [1] min-heap (high half) */
+    uint8_t where[CSI_HAMPEL_MAX_WINDOW];                   /**< heap id (bit 7) and position of each slot */
+    uint8_t size[2];
+    uint8_t count;
+    uint8_t head;                                           /**< oldest slot once the window is full */
+    uint8_t window;
+} csi_median_t;
+
+typedef struct {
+    csi_median_t value;
+    csi_median_t resid;
+} csi_hampel_channel_t;
+
+typedef struct {
+    csi_hampel_channel_t ch[CSI_HAMPEL_MAX_CHANNELS];
+    int window;
+    float n_sigmas;
+    float min_dev;
+    uint32_t samples;    /**< samples seen since init */
+    uint32_t replaced;   /**< samples replaced by the median since init */
+} csi_hampel_t;
+
+/**
+ * @brief Reset a sliding median
+ * @param[in] window number of samples, 1..CSI_HAMPEL_MAX_WINDOW
+ */
+void csi_median_init(csi_median_t *m, int window);
+
+/**
+ * @brief Add a sample (dropping the oldest once full) and return the new median
+ */
+float csi_median_push(csi_median_t *m, float x);
+
+/**
+ * @brief Reset the filter
+ * @param[in] window samples per subcarrier window, clamped to 1..CSI_HAMPEL_MAX_WINDOW
+ * @param[in] n_sigmas outlier threshold in robust standard deviations (3 is typical)
+ * @param[in] min_dev smallest residual that may be treated as an outlier
+ */
+void csi_hampel_init(csi_hampel_t *f, int window, float n_sigmas, float min_dev);
+
+/**
+ * @brief Filter one frame of amplitudes in place
+ * @param[in,out] frame amplitudes, one per subcarrier
+ * @param[in] n number of subcarriers, extra ones beyond CSI_HAMPEL_MAX_CHANNELS are left as is
+ * @return number of samples replaced in this frame
+ */
+int csi_hampel_process_frame(csi_hampel_t *f, float *frame, int n);
+
+#ifdef __cplusplus
+}
+#endif
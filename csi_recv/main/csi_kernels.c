@@ -0,0 +1,146 @@
+/* CSI Kernels
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <math.h>
+#include "csi_kernels.h"
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+#if defined(CSI_KERNELS_FORCE_SCALAR)
+#define CSI_KERNELS_SCALAR 1
+#elif defined(CONFIG_IDF_TARGET_ESP32S3) && defined(CSI_KERNELS_USE_ESP_DSP)
+#define CSI_KERNELS_ESP_DSP 1
+#include "dsps_add.h"
+#include "dsps_mul.h"
+#elif defined(__AVX2__)
+#define CSI_KERNELS_AVX2 1
+#include <immintrin.h>
+#else
+#define CSI_KERNELS_SCALAR 1
+#endif
+
+//------------------------------------------------------Scalar Reference------------------------------------------------------
+void csi_amplitude_f32_ref(const int8_t *iq, float *out, int n_pairs)
+{
+    for (int k = 0; k < n_pairs; k++) {
+        int16_t imag = (int16_t)iq[2 * k];
+        int16_t real = (int16_t)iq[2 * k + 1];
+        out[k] = sqrtf((float)(imag * imag + real * real));
+    }
+}
+
+void csi_window_accumulate_f32_ref(const float *frame, float *sum, float *sum_sq, int n)
+{
+    for (int i = 0; i < n; i++) {
+        float val = frame[i];
+        sum[i] += val;
+        sum_sq[i] += val * val;
+    }
+}
+
+//------------------------------------------------------AVX2 Backend------------------------------------------------------
+#if CSI_KERNELS_AVX2
+void csi_amplitude_f32(const int8_t *iq, float *out, int n_pairs)
+{
+    int k = 0;
+    for (; k + 8 <= n_pairs; k += 8) {
+        // 8 pairs = 16 bytes, widened to int16 so madd gives imag^2 + real^2 per pair
+        __m128i raw = _mm_loadu_si128((const __m128i *)(iq + 2 * k));
+        __m256i v16 = _mm256_cvtepi8_epi16(raw);
+        __m256i pow = _mm256_madd_epi16(v16, v16);
+        _mm256_storeu_ps(out + k, _mm256_sqrt_ps(_mm256_cvtepi32_ps(pow)));
+    }
+    csi_amplitude_f32_ref(iq + 2 * k, out + k, n_pairs - k);
+}
+
+void csi_window_accumulate_f32(const float *frame, float *sum, float *sum_sq, int n)
+{
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 val = _mm256_loadu_ps(frame + i);
+        _mm256_storeu_ps(sum + i, _mm256_add_ps(_mm256_loadu_ps(sum + i), val));
+        _mm256_storeu_ps(sum_sq + i, _mm256_add_ps(_mm256_loadu_ps(sum_sq + i), _mm256_mul_ps(val, val)));
+    }
+    csi_window_accumulate_f32_ref(frame + i, sum + i, sum_sq + i, n - i);
+}
+
+const char *csi_kernels_backend(void)
+{
+    return "avx2";
+}
+#endif
+
+//------------------------------------------------------ESP-DSP Backend------------------------------------------------------
+#if CSI_KERNELS_ESP_DSP
+// Opt-in only: not yet built, checked against the reference or timed on an ESP32-S3, and it
+// makes several passes per frame where the scalar loop makes one. Scratch lives on the caller's
+// stack so the backend stays reentrant like the others; keep the chunk small for the Wi-Fi task stack.
+#define CSI_KERNELS_CHUNK 16 // I/Q pairs converted per pass
+
+void csi_amplitude_f32(const int8_t *iq, float *out, int n_pairs)
+{
+    float iq_f32[2 * CSI_KERNELS_CHUNK];
+    float iq_sq[2 * CSI_KERNELS_CHUNK];
+    while (n_pairs > 0) {
+        int n = n_pairs < CSI_KERNELS_CHUNK ? n_pairs : CSI_KERNELS_CHUNK;
+        for (int j = 0; j < 2 * n; j++) {
+            iq_f32[j] = (float)iq[j];
+        }
+        // Squares and pair sums are small integers, so they stay exact in float
+        dsps_mul_f32(iq_f32, iq_f32, iq_sq, 2 * n, 1, 1, 1);
+        dsps_add_f32(iq_sq, iq_sq + 1, out, n, 2, 2, 1);
+        for (int k = 0; k < n; k++) {
+            out[k] = sqrtf(out[k]);
+        }
+        iq += 2 * n;
+        out += n;
+        n_pairs -= n;
+    }
+}
+
+void csi_window_accumulate_f32(const float *frame, float *sum, float *sum_sq, int n)
+{
+    float frame_sq[CSI_KERNELS_CHUNK];
+    while (n > 0) {
+        int m = n < CSI_KERNELS_CHUNK ? n : CSI_KERNELS_CHUNK;
+        dsps_add_f32(frame, sum, sum, m, 1, 1, 1);
+        dsps_mul_f32(frame, frame, frame_sq, m, 1, 1, 1);
+        dsps_add_f32(frame_sq, sum_sq, sum_sq, m, 1, 1, 1);
+        frame += m;
+        sum += m;
+        sum_sq += m;
+        n -= m;
+    }
+}
+
+const char *csi_kernels_backend(void)
+{
+    return "esp-dsp";
+}
+#endif
+
+//------------------------------------------------------Scalar Backend------------------------------------------------------
+#if CSI_KERNELS_SCALAR
+void csi_amplitude_f32(const int8_t *iq, float *out, int n_pairs)
+{
+    csi_amplitude_f32_ref(iq, out, n_pairs);
+}
+
+void csi_window_accumulate_f32(const float *frame, float *sum, float *sum_sq, int n)
+{
+    csi_window_accumulate_f32_ref(frame, sum, sum_sq, n);
+}
+
+const char *csi_kernels_backend(void)
+{
+    return "scalar";
+}
+#endif
@@ -0,0 +1,76 @@
+/* CSI Kernels
+
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/**
+ * Small numeric kernels used by the CSI receive pipeline.
+ *
+ * Every kernel has a scalar reference implementation. A vectorized backend is
+ * picked at build time:
+ *   - x86 hosts: AVX2, when compiled with -mavx2 (replay / ingest tools)
+ *   - everything else, ESP32-S3 included: the scalar reference
+ *
+ * An experimental ESP32-S3 backend on ESP-DSP dsps_add_f32 / dsps_mul_f32
+ * (Xtensa ae32 variants, not PIE) is compiled only when CSI_KERNELS_USE_ESP_DSP
+ * is defined, e.g. with
+ *   target_compile_definitions(${COMPONENT_LIB} PRIVATE CSI_KERNELS_USE_ESP_DSP)
+ * in main/CMakeLists.txt. It has not been built, checked against the reference
+ * or timed on an S3; run kernels_bench there before enabling it.
+ *
+ * Define CSI_KERNELS_FORCE_SCALAR to always use the scalar reference.
+ * All kernels work on contiguous frames, so callers should keep CSI amplitudes
+ * stored frame after frame (subcarriers adjacent in memory).
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Convert interleaved I/Q samples to amplitudes
+ * @param[in] iq interleaved samples, iq[2k] = imag, iq[2k + 1] = real
+ * @param[out] out amplitudes, out[k] = sqrt(imag^2 + real^2)
+ * @param[in] n_pairs number of I/Q pairs
+ *
+ * All backends are bit-exact with the scalar reference.
+ */
+void csi_amplitude_f32(const int8_t *iq, float *out, int n_pairs);
+
+/**
+ * @brief Accumulate one frame into per-subcarrier window statistics
+ * @param[in] frame amplitudes of one frame
+ * @param[in,out] sum running sum per subcarrier
+ * @param[in,out] sum_sq running sum of squares per subcarrier
+ * @param[in] n number of subcarriers
+ *
+ * Vector backends may differ from the scalar reference within float rounding.
+ */
+void csi_window_accumulate_f32(const float *frame, float *sum, float *sum_sq, int n);
+
+/**
+ * @brief Scalar reference of csi_amplitude_f32()
+ */
+void csi_amplitude_f32_ref(const int8_t *iq, float *out, int n_pairs);
+
+/**
+ * @brief Scalar reference of csi_window_accumulate_f32()
+ */
+void csi_window_accumulate_f32_ref(const float *frame, float *sum, float *sum_sq, int n);
+
+/**
+ * @brief Name of the backend selected at build time ("scalar", "avx2", "esp-dsp")
+ */
+const char *csi_kernels_backend(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -3,9 +3,40 @@ import pandas as pd
 from collections import deque
 import os
 
+class HampelFilter:
+    """Causal per-subcarrier Hampel-style filter, same rule as csi_recv/main/csi_hampel.c.
+
+    The scale is the median of the last window_size residuals, each taken against the
+    median when that sample arrived, not the MAD of the current window.
+    """
+
+    def __init__(self, window_size=9, n_sigmas=3.0, min_dev=2.0):
+        self.values = deque(maxlen=window_size)
+        self.resids = deque(maxlen=window_size)
+        self.n_sigmas = n_sigmas
+        self.min_dev = min_dev
+        self.replaced = 0
+
+    def update(self, amplitude):
+        self.values.append(amplitude)
+        med = np.median(np.stack(self.values), axis=0)
+        resid = np.abs(amplitude - med)
+
+        out = amplitude
+        if len(self.resids) == self.resids.maxlen:
+            resid_scale = np.median(np.stack(self.resids), axis=0)
+            limit = np.maximum(self.n_sigmas * 1.4826 * resid_scale, self.min_dev)
+            outlier = resid > limit
+            self.replaced += int(outlier.sum())
+            out = np.where(outlier, med, amplitude)
+        self.resids.append(resid)
+        return out
+
+
 class MotionDetector:
-    def __init__(self, window_size=100, threshold=4.0):
+    def __init__(self, window_size=100, threshold=4.0, hampel=None):
         self.window = deque(maxlen=window_size)
+        self.hampel = hampel
         self.threshold = threshold
         self.last_state = None
         self.expected_len = None
@@ -28,6 +59,8 @@ class MotionDetector:
             if len(amplitude) != self.expected_len:
                 return None
 
+            if self.hampel is not None:
+                amplitude = self.hampel.update(amplitude)
             self.window.append(amplitude)
 
             self.counter += 1
@@ -61,25 +94,31 @@ def main():
             print(f"\n📂 Processing file: {file_name}")
 
             csi_lines = read_csi_data_from_csv(file_path)
-            motion_detector = MotionDetector(window_size=100, threshold=4.0)
-
-            true_count = 0
-            total_count = 0
-
-            for idx, csi_line in enumerate(csi_lines):
-                result = motion_detector.update(csi_line)
-                if result is not None:
-                    total_count += 1
-                    if result:
-                        true_count += 1
-
-            if total_count > 0:
-                ratio = true_count / total_count
-                print(f"📉 Minimum std during detection: {min(motion_detector.std_list):.6f}")
-                print(f"📊 Detected True in {true_count} out of {total_count} frames.")
-                print(f"✅ Motion Detected Ratio: {ratio:.2%}")
-            else:
-                print("⚠️ 没有有效的帧被处理（可能都是异常帧）。")
+
+            # Compare the raw pipeline with the Hampel-filtered one on the same capture
+            for label, hampel in (("raw", None), ("hampel", HampelFilter())):
+                motion_detector = MotionDetector(window_size=100, threshold=4.0, hampel=hampel)
+
+                true_count = 0
+                total_count = 0
+
+                for idx, csi_line in enumerate(csi_lines):
+                    result = motion_detector.update(csi_line)
+                    if result is not None:
+                        total_count += 1
+                        if result:
+                            true_count += 1
+
+                if total_count > 0:
+                    ratio = true_count / total_count
+                    print(f"[{label}] 📉 Minimum std during detection: {min(motion_detector.std_list):.6f}")
+                    print(f"[{label}] 📈 Mean std during detection: {np.mean(motion_detector.std_list):.6f}")
+                    print(f"[{label}] 📊 Detected True in {true_count} out of {total_count} frames.")
+                    print(f"[{label}] ✅ Motion Detected Ratio: {ratio:.2%}")
+                    if hampel is not None:
+                        print(f"[{label}] 🧹 Replaced samples: {hampel.replaced}")
+                else:
+                    print("⚠️ 没有有效的帧被处理（可能都是异常帧）。")
 
 if __name__ == "__main__":
     main()
\ No newline at end of file
@@ -1,10 +1,33 @@
+import struct
 import paho.mqtt.client as mqtt
 
+# Backlog records from csi_recv/main/csi_flash_log.h: state, type, len, time_ms, then a 4-byte padded payload
+RECORD_HDR = struct.Struct("<BBHI")
+CSI_LOG_TYPE_FRAME = 1
+CSI_LOG_TYPE_RESULT = 2
+
+def decode_backlog(payload):
+    off = 0
+    while off + RECORD_HDR.size <= len(payload):
+        _, rtype, length, time_ms = RECORD_HDR.unpack_from(payload, off)
+        data = payload[off + RECORD_HDR.size: off + RECORD_HDR.size + length]
+        off += RECORD_HDR.size + ((length + 3) & ~3)
+        if rtype == CSI_LOG_TYPE_FRAME:
+            csi = struct.unpack(f"<{length}b", data)
+            print(f"[BACKLOG CSI] t={time_ms}ms [{','.join(map(str, csi))}]")
+        elif rtype == CSI_LOG_TYPE_RESULT:
+            motion, breathing_rate = struct.unpack("<hh", data)
+            print(f"[BACKLOG RESULT] t={time_ms}ms {{\"motion\": {motion}, \"breathing_rate\": {breathing_rate}}}")
+
 def on_connect(client, userdata, flags, rc):
     print("✅ Connected with result code " + str(rc))
     client.subscribe("/esp32/csi")
+    client.subscribe("/esp32/csi/backlog")
 
 def on_message(client, userdata, msg):
+    if msg.topic == "/esp32/csi/backlog":
+        decode_backlog(msg.payload)
+        return
     decoded = msg.payload.decode()
     print(f"[CSI] {decoded}")
 